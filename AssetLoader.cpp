@@ -0,0 +1,342 @@
+#include "AssetLoader.h"
+#include "ObjectLoader.h"
+#include "RenderThread.h"
+#include "CPUProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+//Class variables defined out of scope
+std::vector<std::thread> AssetLoader::workers;
+std::deque<std::function<void()>> AssetLoader::workQueue;
+std::deque<std::function<void()>> AssetLoader::uploadQueue;
+std::mutex AssetLoader::workMutex;
+std::mutex AssetLoader::uploadMutex;
+std::mutex AssetLoader::cacheMutex;
+std::condition_variable AssetLoader::workAvailable;
+bool AssetLoader::bStopping = false;
+std::atomic<int> AssetLoader::jobsQueued(0);
+std::atomic<int> AssetLoader::jobsFinished(0);
+std::map<std::string, MeshAsset*> AssetLoader::meshCache;
+std::map<std::string, TextureAsset*> AssetLoader::textureCache;
+
+//Creates the worker threads, one less than the number of cores so the simulation keeps a core to itself
+void AssetLoader::Start()
+{
+	bStopping = false;
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	threadCount = threadCount > 1 ? threadCount - 1 : 1;
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.push_back(std::thread(workerLoop));
+	}
+}
+
+//Tells every worker to finish and waits for them, any work still queued is thrown away
+void AssetLoader::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		bStopping = true;
+		workQueue.clear();
+	}
+	workAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+}
+
+//Each worker waits for work, runs it and then hands the upload over to the render thread
+void AssetLoader::workerLoop()
+{
+	PROFILE_THREAD("Asset loader");
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(workMutex);
+			workAvailable.wait(lock, [] { return bStopping || !workQueue.empty(); });
+			if (bStopping) {
+				return;
+			}
+			job = std::move(workQueue.front());
+			workQueue.pop_front();
+		}
+		job();
+	}
+}
+
+void AssetLoader::queueJob(std::function<void()> work, std::function<void()> upload)
+{
+	jobsQueued++;
+	//The upload is wrapped so the job is only counted as finished once it has been uploaded
+	std::function<void()> finish = [upload]() {
+		PROFILE_ZONE("Asset upload");
+		if (upload) {
+			upload();
+		}
+		jobsFinished++;
+	};
+	std::function<void()> job = [work, finish]() {
+		{
+			PROFILE_ZONE("Asset load");
+			if (work) {
+				work();
+			}
+		}
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		uploadQueue.push_back(finish);
+	};
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		workQueue.push_back(job);
+	}
+	workAvailable.notify_one();
+}
+
+//Called on the render thread every frame, uploads finished results until the time budget runs out
+//The rest stay queued for the next frame so a frame is never held up by a large batch of uploads
+void AssetLoader::processUploads(float budgetMs)
+{
+	PROFILE_ZONE("AssetLoader::processUploads");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (true) {
+		std::function<void()> upload;
+		{
+			std::lock_guard<std::mutex> lock(uploadMutex);
+			if (uploadQueue.empty()) {
+				return;
+			}
+			upload = std::move(uploadQueue.front());
+			uploadQueue.pop_front();
+		}
+		//Uploads can queue more jobs (e.g. the GUI requests its images once the font has loaded), so the lock isn't held while it runs
+		upload();
+
+		float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= budgetMs) {
+			return;
+		}
+	}
+}
+
+//Returns the mesh for an OBJ file, the file is parsed on a worker and buffered into OpenGL when it's ready
+//Every object using the same file shares one mesh, so a model is only ever loaded once
+MeshAsset* AssetLoader::requestMesh(const char* path)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::map<std::string, MeshAsset*>::iterator cached = meshCache.find(path);
+	if (cached != meshCache.end()) {
+		cached->second->refCount++;
+		return cached->second;
+	}
+	MeshAsset* mesh = new MeshAsset();
+	mesh->refCount = 1;
+	mesh->cacheKey = path;
+	meshCache[path] = mesh;
+
+	struct MeshData {
+		std::vector<glm::vec3> vertexData, normalData;
+		std::vector<glm::vec2> uvData;
+		glm::vec3 boundsCenter;
+		float boundsRadius;
+	};
+	std::shared_ptr<MeshData> data = std::make_shared<MeshData>();
+	std::string meshPath = filePath(path);
+
+	queueJob([data, meshPath]() {
+		ObjectLoader::loadOBJ(meshPath.c_str(), data->vertexData, data->uvData, data->normalData);
+		//The bounding sphere is centred on the middle of the mesh's box, and reaches the vertex furthest from it
+		glm::vec3 minimum = glm::vec3(0.f), maximum = glm::vec3(0.f);
+		if (!data->vertexData.empty()) {
+			minimum = maximum = data->vertexData[0];
+		}
+		for (const glm::vec3& vertex : data->vertexData) {
+			minimum = glm::min(minimum, vertex);
+			maximum = glm::max(maximum, vertex);
+		}
+		data->boundsCenter = (minimum + maximum) * 0.5f;
+		float radiusSquared = 0.f;
+		for (const glm::vec3& vertex : data->vertexData) {
+			glm::vec3 offset = vertex - data->boundsCenter;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		data->boundsRadius = std::sqrt(radiusSquared);
+	}, [data, mesh, meshPath]() {
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+			mesh->bPending = false;
+			//Everything using the mesh was destroyed before it finished loading
+			if (mesh->refCount == 0) {
+				delete mesh;
+				return;
+			}
+		}
+		if (data->vertexData.empty()) {
+			std::cout << "Failed to load model: " << meshPath << std::endl;
+			return;
+		}
+		//Buffers all the vertex and uv and normal data into their own buffers and records the layout in the vertex array object
+		glGenVertexArrays(1, &mesh->VertexArrayID);
+		glBindVertexArray(mesh->VertexArrayID);
+
+		glGenBuffers(1, &mesh->vertexBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, data->vertexData.size() * sizeof(glm::vec3), &data->vertexData[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+		glGenBuffers(1, &mesh->uvBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->uvBuffer);
+		glBufferData(GL_ARRAY_BUFFER, data->uvData.size() * sizeof(glm::vec2), &data->uvData[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+		glGenBuffers(1, &mesh->normalBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->normalBuffer);
+		glBufferData(GL_ARRAY_BUFFER, data->normalData.size() * sizeof(glm::vec3), &data->normalData[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+		glBindVertexArray(0);
+		mesh->vertexCount = (GLsizei)data->vertexData.size();
+		mesh->boundsCenter = data->boundsCenter;
+		mesh->boundsRadius = data->boundsRadius;
+		mesh->loaded = true;
+	});
+	return mesh;
+}
+
+//Returns the texture for an image, the image is decoded on a worker and buffered into OpenGL when it's ready
+TextureAsset* AssetLoader::requestTexture(const char* path, bool flipVertically)
+{
+	//The same image can be loaded both ways up, so the orientation is part of the key
+	std::string key = std::string(path) + (flipVertically ? "|flipped" : "");
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::map<std::string, TextureAsset*>::iterator cached = textureCache.find(key);
+	if (cached != textureCache.end()) {
+		cached->second->refCount++;
+		return cached->second;
+	}
+	TextureAsset* texture = new TextureAsset();
+	texture->refCount = 1;
+	texture->cacheKey = key;
+	textureCache[key] = texture;
+
+	std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+	std::shared_ptr<bool> decoded = std::make_shared<bool>(false);
+	std::string texturePath = filePath(path);
+
+	queueJob([data, decoded, texturePath, flipVertically]() {
+		*decoded = ObjectLoader::decodeTexture(texturePath.c_str(), flipVertically, *data);
+	}, [data, decoded, texture]() {
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+			texture->bPending = false;
+			if (texture->refCount == 0) {
+				if (*decoded) {
+					ObjectLoader::freeTexture(*data);
+				}
+				delete texture;
+				return;
+			}
+		}
+		if (!*decoded) {
+			return;
+		}
+		texture->id = ObjectLoader::uploadTexture(*data, texture->width, texture->height, texture->flipped);
+		texture->loaded = true;
+	});
+	return texture;
+}
+
+//The asset is taken out of the cache straight away, so asking for the same file again loads a fresh copy
+//If it's still loading it can't be deleted yet, the upload sees that nothing is using it and deletes it instead
+//Otherwise it's deleted on the render thread once it has moved past every snapshot that could still draw it
+void AssetLoader::releaseMesh(MeshAsset* mesh)
+{
+	if (mesh == nullptr) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (--mesh->refCount > 0) {
+		return;
+	}
+	meshCache.erase(mesh->cacheKey);
+	if (!mesh->bPending) {
+		RenderThread::queueGLJob([mesh]() { deleteMesh(mesh); });
+	}
+}
+
+void AssetLoader::releaseTexture(TextureAsset* texture)
+{
+	if (texture == nullptr) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (--texture->refCount > 0) {
+		return;
+	}
+	textureCache.erase(texture->cacheKey);
+	if (!texture->bPending) {
+		RenderThread::queueGLJob([texture]() { deleteTexture(texture); });
+	}
+}
+
+void AssetLoader::deleteMesh(MeshAsset* mesh)
+{
+	//Deleting buffer 0 does nothing, so a mesh that failed to load can be deleted the same way
+	GLuint buffers[3] = { mesh->vertexBuffer, mesh->uvBuffer, mesh->normalBuffer };
+	glDeleteBuffers(3, buffers);
+	GLuint vertexArrays[2] = { mesh->VertexArrayID, mesh->instancedVertexArrayID };
+	glDeleteVertexArrays(2, vertexArrays);
+	delete mesh;
+}
+
+void AssetLoader::deleteTexture(TextureAsset* texture)
+{
+	glDeleteTextures(1, &texture->id);
+	delete texture;
+}
+
+//Reads a text file on a worker thread, onLoaded is called with the contents on the render thread
+void AssetLoader::requestTextFile(const char* path, std::function<void(const std::string&)> onLoaded)
+{
+	std::shared_ptr<std::string> contents = std::make_shared<std::string>();
+	std::string textPath = filePath(path);
+	queueJob([contents, textPath]() {
+		std::ifstream file(textPath);
+		std::string nextLine;
+		while (std::getline(file, nextLine)) {
+			*contents += nextLine + "\n";
+		}
+	}, [contents, onLoaded]() {
+		onLoaded(*contents);
+	});
+}
+
+std::string AssetLoader::filePath(const char* path)
+{
+	std::string platformPath = path;
+#ifndef _WIN32
+	std::replace(platformPath.begin(), platformPath.end(), '\\', '/');
+#endif
+	return platformPath;
+}
+
+bool AssetLoader::isBusy()
+{
+	return jobsFinished < jobsQueued;
+}
+
+float AssetLoader::getProgress()
+{
+	int queued = jobsQueued;
+	if (queued == 0) {
+		return 1.f;
+	}
+	return (float)jobsFinished / (float)queued;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//A model that has been buffered into OpenGL, shared by every object that uses the same OBJ file
+//The vertex array object remembers the layout of all 3 buffers, so drawing only needs to bind it
+struct MeshAsset {
+	GLuint VertexArrayID = 0;
+	GLuint vertexBuffer = 0, uvBuffer = 0, normalBuffer = 0;
+	GLsizei vertexCount = 0;
+	//A sphere around every vertex of the mesh (in the model's own space), used to check if the mesh can be seen
+	glm::vec3 boundsCenter = glm::vec3(0.f);
+	float boundsRadius = 0.f;
+	//False until the render thread has uploaded the mesh, the simulation checks it before drawing anything with the mesh
+	std::atomic<bool> loaded{ false };
+	//Only made (on the render thread) if the mesh is drawn instanced, the same layout plus a per instance vec4 (read from the render thread's stream buffer)
+	GLuint instancedVertexArrayID = 0;
+	//How many objects are using the mesh, it's deleted when the last one releases it
+	int refCount = 0;
+	bool bPending = true; //True until the upload has run (even if loading failed)
+	std::string cacheKey;
+};
+
+//A texture that has been buffered into OpenGL, shared by every object that uses the same image
+struct TextureAsset {
+	GLuint id = 0;
+	int width = 0, height = 0;
+	bool flipped = false; //True if the texture loaded upside down compared to what was asked for
+	std::atomic<bool> loaded{ false };
+	int refCount = 0;
+	bool bPending = true;
+	std::string cacheKey;
+};
+
+//The AssetLoader does the slow part of loading (reading files, decoding pngs, parsing OBJ files) on a pool of worker threads
+//OpenGL can only be used from the render thread, so once a worker finishes its result is queued and uploaded by processUploads
+//processUploads is called once a frame (by the render thread) and only runs for a limited time, so the window keeps responding while things load
+//Meshes and textures can be requested and released from any thread
+class AssetLoader
+{
+public:
+	static void Start();
+	static void Stop();
+
+	//work runs on a worker thread, upload runs on the render thread once work has finished (either can be empty)
+	static void queueJob(std::function<void()> work, std::function<void()> upload);
+	//Runs queued uploads until budgetMs milliseconds have passed (always runs at least one)
+	static void processUploads(float budgetMs);
+
+	//Returns the shared mesh or texture for a file, loading it in the background the first time it is asked for
+	//Every request adds a reference, which should be given back with releaseMesh/releaseTexture once it's no longer needed
+	static MeshAsset* requestMesh(const char* path);
+	static TextureAsset* requestTexture(const char* path, bool flipVertically = true);
+	//Removes a reference, when nothing is using a mesh or texture any more its OpenGL buffers are deleted (on the render thread)
+	static void releaseMesh(MeshAsset* mesh);
+	static void releaseTexture(TextureAsset* texture);
+	//Reads a whole text file (a shader) on a worker, then calls onLoaded with its contents on the render thread
+	static void requestTextFile(const char* path, std::function<void(const std::string&)> onLoaded);
+	//Asset paths are written with Windows separators (Models\\cube.obj), this changes them to forward slashes on other platforms
+	static std::string filePath(const char* path);
+
+	//True while any job is still being worked on or waiting to be uploaded
+	static bool isBusy();
+	//How much of everything that has been queued so far has finished, between 0 and 1
+	static float getProgress();
+
+private:
+	static void workerLoop();
+	static void deleteMesh(MeshAsset* mesh);
+	static void deleteTexture(TextureAsset* texture);
+
+	static std::vector<std::thread> workers;
+	static std::deque<std::function<void()>> workQueue;
+	static std::deque<std::function<void()>> uploadQueue;
+	static std::mutex workMutex, uploadMutex;
+	//Guards the caches and every asset's refCount and bPending
+	static std::mutex cacheMutex;
+	static std::condition_variable workAvailable;
+	static bool bStopping;
+	static std::atomic<int> jobsQueued, jobsFinished;
+
+	static std::map<std::string, MeshAsset*> meshCache;
+	static std::map<std::string, TextureAsset*> textureCache;
+};
@@ -1,5 +1,7 @@
 #include "AudioManager.h"
+#include "CPUProfiler.h"
 
+#include <algorithm>
 #include <iostream>
 
 const ALCuint rate = 44100;
@@ -11,7 +13,7 @@ double pi = 2 * acos(0.0);
 std::complex<double> posi = std::complex<double>(0.f, 1.f);
 
 //The buffer that is written to when capturing microphone input
-INT16 CaptureBuffer[22050];
+int16_t CaptureBuffer[22050];
 float deltaCheck;
 
 
@@ -138,6 +140,7 @@ float AudioManager::getHeightOfNote(int ind, float fovy, float dist)
 
 void AudioManager::updateFrequency(float dt, double &note, double &volume) 
 {
+	PROFILE_ZONE("AudioManager::updateFrequency");
 
 	deltaCheck += dt;
 	
@@ -155,9 +158,18 @@ void AudioManager::updateFrequency(float dt, double &note, double &volume)
 	
 	deltaCheck = 0.f;
 	//If the capture buffer is full enough then copy the samples over into the capture Buffer
+	//After a stall the device can hold more than the buffer fits, the oldest samples are captured a buffer at a time and thrown away so the ones kept are the newest
+	const ALint capacity = (ALint)(sizeof(CaptureBuffer) / sizeof(CaptureBuffer[0]));
+	while (samplesAvailable > capacity) {
+		ALint discard = std::min(samplesAvailable - capacity, capacity);
+		alcCaptureSamples(captureDev, (ALvoid*)CaptureBuffer, discard);
+		samplesAvailable -= discard;
+	}
 	alcCaptureSamples(captureDev, (ALvoid*)CaptureBuffer, samplesAvailable);
 	//Copies only a sample size number of the capture buffer (to make sure the size is always a power of 2 and consistent)
-	std::vector<std::complex<double>> captureOutput(CaptureBuffer, CaptureBuffer + (size));
+	//The newest samples are at the end, so the pitch is always of what's being sung right now rather than what was sung a frame ago
+	int16_t* newestSamples = CaptureBuffer + (samplesAvailable - size);
+	std::vector<std::complex<double>> captureOutput(newestSamples, newestSamples + (size));
 	//Copy data over from the vector to the a valarray (which is the input type of the YIN algorithm)
 	std::valarray<std::complex<double>> captureOutputVal(captureOutput.data(), captureOutput.size());
 	//Calculate the pitch with the YIN algorithm
@@ -175,3 +187,8 @@ void AudioManager::updateFrequency(float dt, double &note, double &volume)
 
 }
 
+//The pitch is detected over size samples, the middle of which is half of them old by the time they've all arrived
+float AudioManager::getAnalysisLatencyMs()
+{
+	return size * 0.5f / rate * 1000.f;
+}
@@ -1,7 +1,7 @@
 #include <AL/alc.h>
 #include <AL/al.h>
 #include <sndfile.h>
-#include <Windows.h>
+#include <cstdint>
 #include <valarray>
 #include <complex>
 #include <chrono>
@@ -38,5 +38,7 @@ public:
 	float getPlayPos();
 
 	static float getHeightOfNote(int ind, float fovy, float dist);
+	//How old the samples a pitch is detected from are on average when updateFrequency returns it (in milliseconds)
+	static float getAnalysisLatencyMs();
 };
 
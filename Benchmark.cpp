@@ -0,0 +1,222 @@
+#include "Benchmark.h"
+#include "AssetLoader.h"
+#include "GameManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+//Class variables defined out of scope
+int Benchmark::frameCount = 600;
+int Benchmark::width = 1280;
+int Benchmark::height = 720;
+const float Benchmark::frameTime = 1.f / 60.f;
+std::string Benchmark::chartPath = "Counting Stars Audio\\notes30s.json";
+std::string Benchmark::pitchPath;
+std::string Benchmark::outputPath = "BenchmarkFrames.csv";
+std::vector<Benchmark::PitchSample> Benchmark::pitchTrack;
+std::vector<int> Benchmark::captureFrames;
+std::vector<unsigned char> Benchmark::capturePixels;
+int Benchmark::captureWidth = 0;
+int Benchmark::captureHeight = 0;
+std::vector<Benchmark::FrameTimes> Benchmark::frames;
+std::map<unsigned long long, Benchmark::GPUTimes> Benchmark::gpuFrames;
+std::mutex Benchmark::gpuFramesMutex;
+
+//How long before a note arrives the generated pitch track starts singing it, so the player has time to move
+const float generatedLeadTime = 0.25f;
+//Loud enough to get past the volume check in the main code
+const double generatedVolume = 1000.0;
+
+bool Benchmark::parseArguments(int argc, char** argv, int first)
+{
+	for (int i = first; i < argc; i++) {
+		std::string option = argv[i];
+		bool bHasValue = i + 1 < argc;
+		if (option == "--frames" && bHasValue) {
+			frameCount = std::atoi(argv[++i]);
+		}
+		else if (option == "--size" && bHasValue) {
+			if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2) {
+				width = 0;
+			}
+		}
+		else if (option == "--chart" && bHasValue) {
+			chartPath = argv[++i];
+		}
+		else if (option == "--pitch" && bHasValue) {
+			pitchPath = argv[++i];
+		}
+		else if (option == "--output" && bHasValue) {
+			outputPath = argv[++i];
+		}
+		else if (option == "--capture" && bHasValue) {
+			//A comma separated list of frame numbers
+			std::stringstream list(argv[++i]);
+			std::string frame;
+			while (std::getline(list, frame, ',')) {
+				captureFrames.push_back(std::atoi(frame.c_str()));
+			}
+		}
+		else {
+			frameCount = 0;
+			break;
+		}
+	}
+	if (frameCount <= 0 || width <= 0 || height <= 0) {
+		std::cout << "Usage: --headless [--frames N] [--size WIDTHxHEIGHT] [--chart notes.json] [--pitch track.txt] [--capture N,N,...] [--output frames.csv]" << std::endl;
+		std::cout << "A pitch track has a line for every change in what's sung: the song time in seconds, the frequency in Hz and the volume" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Benchmark::loadPitchTrack()
+{
+	pitchTrack.clear();
+	if (pitchPath.empty()) {
+		//Sings every note of the chart slightly sharp, so rounding never puts it on the note below
+		std::string songTitle;
+		Json::Value notes;
+		GameManager::loadSongJson(AssetLoader::filePath(chartPath.c_str()).c_str(), songTitle, notes);
+		for (int i = 0; i < (int)notes.size(); i++) {
+			int noteIndex = GameManager::getNoteIndex(notes[i][0].asCString());
+			double frequency = 440.0 * std::pow(2.0, (noteIndex - 0.75) / 12.0);
+			pitchTrack.push_back({ notes[i][1].asFloat() - generatedLeadTime, frequency, generatedVolume });
+		}
+	}
+	else {
+		std::ifstream file(AssetLoader::filePath(pitchPath.c_str()));
+		if (!file.is_open()) {
+			std::cout << "Failed to open pitch track " << pitchPath << std::endl;
+			return false;
+		}
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			PitchSample sample;
+			std::stringstream values(line);
+			if (values >> sample.time >> sample.frequency >> sample.volume) {
+				pitchTrack.push_back(sample);
+			}
+		}
+	}
+	std::sort(pitchTrack.begin(), pitchTrack.end(), [](const PitchSample& a, const PitchSample& b) { return a.time < b.time; });
+	return true;
+}
+
+//Each sample lasts until the next one starts
+void Benchmark::samplePitch(float songTime, double& note, double& volume)
+{
+	std::vector<PitchSample>::const_iterator next = std::upper_bound(pitchTrack.begin(), pitchTrack.end(), songTime,
+		[](float time, const PitchSample& sample) { return time < sample.time; });
+	if (next == pitchTrack.begin()) {
+		note = 0.0;
+		volume = 0.0;
+		return;
+	}
+	note = (next - 1)->frequency;
+	volume = (next - 1)->volume;
+}
+
+bool Benchmark::isCaptureFrame(int frame)
+{
+	return std::find(captureFrames.begin(), captureFrames.end(), frame) != captureFrames.end();
+}
+
+void Benchmark::readCapture(int width, int height)
+{
+	captureWidth = width;
+	captureHeight = height;
+	capturePixels.resize((size_t)width * height * 3);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	//The screen's alpha isn't meaningful, so only RGB is read, rows of 3 byte pixels aren't always a multiple of 4 bytes long
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, capturePixels.data());
+}
+
+//OpenGL's rows start at the bottom of the image, PNG's start at the top
+void Benchmark::writeCapture(int frame)
+{
+	std::string path = "Capture_" + std::to_string(frame) + ".png";
+	stbi_flip_vertically_on_write(1);
+	if (!stbi_write_png(path.c_str(), captureWidth, captureHeight, 3, capturePixels.data(), captureWidth * 3)) {
+		std::cout << "Failed to write " << path << std::endl;
+	}
+}
+
+void Benchmark::recordFrame(int frame, unsigned long long sequence, float simulationMs, float renderMs, bool bCaptured)
+{
+	frames.push_back({ frame, sequence, simulationMs, renderMs, bCaptured });
+}
+
+void Benchmark::recordGPUFrame(unsigned long long sequence, const float* passTimes)
+{
+	GPUTimes times;
+	std::copy(passTimes, passTimes + GPU_PASS_COUNT + 1, times.passTimes);
+	std::lock_guard<std::mutex> lock(gpuFramesMutex);
+	gpuFrames[sequence] = times;
+}
+
+void Benchmark::printSummary(const char* name, std::vector<float> times)
+{
+	if (times.empty()) {
+		std::printf("%-16s no results\n", name);
+		return;
+	}
+	float total = 0.f;
+	for (float time : times) {
+		total += time;
+	}
+	size_t p99Index = std::min(times.size() - 1, (size_t)(times.size() * 0.99f));
+	std::nth_element(times.begin(), times.begin() + p99Index, times.end());
+	std::printf("%-16s avg %6.2f ms  p99 %6.2f ms\n", name, total / times.size(), times[p99Index]);
+}
+
+//Frames whose GPU times were dropped (see GPUProfiler) have empty GPU columns
+void Benchmark::writeResults()
+{
+	std::ofstream file(outputPath, std::ios::out | std::ios::trunc);
+	file << "Frame,Snapshot,Simulation CPU,Render CPU";
+	for (int pass = 0; pass < GPU_PASS_COUNT + 1; pass++) {
+		file << ",GPU " << GPUProfiler::getPassName(pass);
+	}
+	file << ",Captured\n";
+
+	std::vector<float> simulationTimes, renderTimes, gpuTimes;
+	std::lock_guard<std::mutex> lock(gpuFramesMutex);
+	for (const FrameTimes& frame : frames) {
+		file << frame.frame << "," << frame.sequence << "," << frame.simulationMs << "," << frame.renderMs;
+		std::map<unsigned long long, GPUTimes>::const_iterator gpu = gpuFrames.find(frame.sequence);
+		for (int pass = 0; pass < GPU_PASS_COUNT + 1; pass++) {
+			file << ",";
+			if (gpu != gpuFrames.end()) {
+				file << gpu->second.passTimes[pass];
+			}
+		}
+		file << "," << (frame.bCaptured ? 1 : 0) << "\n";
+
+		//Reading a frame back stalls until the GPU has finished it, so captured frames are left out of the averages
+		if (frame.bCaptured) {
+			continue;
+		}
+		simulationTimes.push_back(frame.simulationMs);
+		renderTimes.push_back(frame.renderMs);
+		if (gpu != gpuFrames.end()) {
+			gpuTimes.push_back(gpu->second.passTimes[GPU_PASS_COUNT]);
+		}
+	}
+	std::printf("%d frames at %dx%d, written to %s\n", (int)frames.size(), width, height, outputPath.c_str());
+	printSummary("Simulation CPU", simulationTimes);
+	printSummary("Render CPU", renderTimes);
+	printSummary("GPU", gpuTimes);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "GPUProfiler.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Runs the game without a window to measure how long frames take, e.g. on a build machine with no GPU using Mesa's llvmpipe
+//Started with --headless (see parseArguments for the options), the frames are drawn by the same display function as the game
+//The chart is sung by a pitch track instead of the microphone and every frame moves the game on by the same amount of time, so two runs draw exactly the same frames
+//The CPU and GPU times of every frame are written to a CSV, and chosen frames can be saved as PNGs to check they still look right
+class Benchmark
+{
+public:
+	//Reads the options that come after --headless, prints how to use them and returns false if any are wrong
+	static bool parseArguments(int argc, char** argv, int first);
+	//Loads the pitch track file, or without one makes a track from the chart that sings each note just before it arrives
+	static bool loadPitchTrack();
+	//The frequency and volume being sung at a point in the song, both 0 if nothing is
+	static void samplePitch(float songTime, double& note, double& volume);
+
+	static bool isCaptureFrame(int frame);
+	//Copies the finished frame out of the default framebuffer, called on the render thread
+	static void readCapture(int width, int height);
+	//Saves the frame readCapture last copied as a PNG, called once that frame has been drawn
+	static void writeCapture(int frame);
+
+	//Adds a frame's CPU times, the GPU times arrive later (from the render thread) through recordGPUFrame
+	static void recordFrame(int frame, unsigned long long sequence, float simulationMs, float renderMs, bool bCaptured);
+	static void recordGPUFrame(unsigned long long sequence, const float* passTimes);
+	//Writes every frame to outputPath and prints the averages
+	static void writeResults();
+
+	static int frameCount, width, height;
+	//The time every frame moves the game on by (in seconds)
+	const static float frameTime;
+	static std::string chartPath, pitchPath, outputPath;
+
+private:
+	struct PitchSample {
+		float time;
+		double frequency, volume;
+	};
+	struct FrameTimes {
+		int frame;
+		unsigned long long sequence;
+		float simulationMs, renderMs;
+		bool bCaptured;
+	};
+	struct GPUTimes {
+		float passTimes[GPU_PASS_COUNT + 1];
+	};
+	//Prints the average and 99th percentile of a column of times
+	static void printSummary(const char* name, std::vector<float> times);
+
+	static std::vector<PitchSample> pitchTrack;
+	static std::vector<int> captureFrames;
+	static std::vector<unsigned char> capturePixels;
+	static int captureWidth, captureHeight;
+	static std::vector<FrameTimes> frames;
+	//GPU times by snapshot sequence, written by the render thread
+	static std::map<unsigned long long, GPUTimes> gpuFrames;
+	static std::mutex gpuFramesMutex;
+};
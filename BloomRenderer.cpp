@@ -0,0 +1,84 @@
+#include "BloomRenderer.h"
+
+#include <algorithm>
+
+//Class variables defined out of scope
+const int BloomRenderer::qualityLevels[3] = { 3, 4, 5 };
+void (*BloomRenderer::drawScreenQuad)() = nullptr;
+ShaderProgram BloomRenderer::downsampleProgram;
+ShaderProgram BloomRenderer::upsampleProgram;
+int BloomRenderer::downsampleUVScaleUniform = -1;
+int BloomRenderer::upsampleUVScaleUniform = -1;
+
+void BloomRenderer::Init(void (*drawQuad)())
+{
+	drawScreenQuad = drawQuad;
+}
+
+void BloomRenderer::setPrograms(GLuint downsample, GLuint upsample)
+{
+	//Both programs read from texture unit 0
+	if (downsample != downsampleProgram.getProgram()) {
+		downsampleProgram.reflect(downsample);
+		downsampleProgram.setInt(downsampleProgram.findUniform("sourceTexture"), 0);
+		downsampleUVScaleUniform = downsampleProgram.findUniform("uvScale");
+	}
+	if (upsample != upsampleProgram.getProgram()) {
+		upsampleProgram.reflect(upsample);
+		upsampleProgram.setInt(upsampleProgram.findUniform("sourceTexture"), 0);
+		upsampleUVScaleUniform = upsampleProgram.findUniform("uvScale");
+	}
+}
+
+void BloomRenderer::drawLevel(ShaderProgram& program, int uvScaleUniform, int width, int height, GLuint source, glm::vec2 sourceScale)
+{
+	glViewport(0, 0, width, height);
+	glUseProgram(program.getProgram());
+	program.setVec2(uvScaleUniform, sourceScale);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, source);
+	drawScreenQuad();
+}
+
+//Shrinks the source down to the smallest level, then grows it back up one level at a time
+//Each level grown back up is a new texture the same size as the shrunk one, which has been read for the last time by then, so the frame graph gives both the same memory
+//With 4 levels that's 7 small passes (4 down and 3 up), the largest of which is a quarter of the screen's pixels
+FrameGraphResource BloomRenderer::addPasses(FrameGraph& graph, FrameGraphResource source, int screenWidth, int screenHeight, int sourceWidth, int sourceHeight, int levels, glm::vec2& blurredScale)
+{
+	levels = std::min(std::max(levels, 1), (int)maxLevels);
+
+	//The size of each level's texture, the part of it that's used, and that part as a fraction of the whole texture
+	FrameGraphTextureDesc levelDescs[maxLevels];
+	int usedWidths[maxLevels], usedHeights[maxLevels];
+	glm::vec2 usedScales[maxLevels];
+	for (int i = 0; i < levels; i++) {
+		levelDescs[i] = { std::max(screenWidth >> (i + 1), 1), std::max(screenHeight >> (i + 1), 1), GL_RGBA16F };
+		usedWidths[i] = std::max(sourceWidth >> (i + 1), 1);
+		usedHeights[i] = std::max(sourceHeight >> (i + 1), 1);
+		usedScales[i] = glm::vec2((float)usedWidths[i] / levelDescs[i].width, (float)usedHeights[i] / levelDescs[i].height);
+	}
+
+	FrameGraphResource previous = source;
+	glm::vec2 previousScale((float)sourceWidth / screenWidth, (float)sourceHeight / screenHeight);
+	for (int i = 0; i < levels; i++) {
+		FrameGraphResource level = graph.createTexture(levelDescs[i]);
+		int width = usedWidths[i], height = usedHeights[i];
+		graph.addPass("Bloom downsample", GPU_PASS_BLOOM, { previous }, { level }, [&graph, previous, previousScale, width, height]() {
+			drawLevel(downsampleProgram, downsampleUVScaleUniform, width, height, graph.getTexture(previous), previousScale);
+		});
+		previous = level;
+		previousScale = usedScales[i];
+	}
+
+	for (int i = levels - 2; i >= 0; i--) {
+		FrameGraphResource level = graph.createTexture(levelDescs[i]);
+		int width = usedWidths[i], height = usedHeights[i];
+		graph.addPass("Bloom upsample", GPU_PASS_BLOOM, { previous }, { level }, [&graph, previous, previousScale, width, height]() {
+			drawLevel(upsampleProgram, upsampleUVScaleUniform, width, height, graph.getTexture(previous), previousScale);
+		});
+		previous = level;
+		previousScale = usedScales[i];
+	}
+	blurredScale = previousScale;
+	return previous;
+}
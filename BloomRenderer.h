@@ -0,0 +1,35 @@
+#pragma once
+#include "FrameGraph.h"
+#include "ShaderProgram.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+//Blurs the bright parts of the frame to make them glow
+//Instead of blurring at full size over and over, the image is shrunk down a chain of textures (each half the size of the one before) and then grown back up
+//Every step is a small filter, but because each level is half the size the blur doubles in width every level, for a fraction of the pixels a full size blur would draw
+//Only used on the render thread
+class BloomRenderer
+{
+public:
+	//drawQuad draws a quad over the whole of the bound framebuffer
+	static void Init(void (*drawQuad)());
+	//Called with each program when it's made (or reloaded), the other can still be 0
+	static void setPrograms(GLuint downsample, GLuint upsample);
+	//Adds the passes that blur the bottom left sourceWidth by sourceHeight pixels of source (a screenWidth by screenHeight texture) and returns the blurred texture
+	//levels is how many levels of the chain are used, more levels give a wider and smoother glow
+	//When the frame is drawn smaller than the screen (see DynamicResolution) only part of each level is used, blurredScale is the part of the returned texture that is
+	static FrameGraphResource addPasses(FrameGraph& graph, FrameGraphResource source, int screenWidth, int screenHeight, int sourceWidth, int sourceHeight, int levels, glm::vec2& blurredScale);
+
+	const static int maxLevels = 5;
+	//The number of levels for each of the quality options (Low, Medium, High)
+	static const int qualityLevels[3];
+
+private:
+	//Draws one level into the bound framebuffer, sourceScale is the part of the source texture to read from
+	static void drawLevel(ShaderProgram& program, int uvScaleUniform, int width, int height, GLuint source, glm::vec2 sourceScale);
+
+	static void (*drawScreenQuad)();
+	static ShaderProgram downsampleProgram, upsampleProgram;
+	static int downsampleUVScaleUniform, upsampleUVScaleUniform;
+};
@@ -0,0 +1,97 @@
+#include "CPUProfiler.h"
+
+#if CPU_PROFILER_ENABLED
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+//Class variables defined out of scope
+const char* const CPUProfiler::tracePath = "CPUTrace.json";
+thread_local CPUProfiler::ThreadBuffer* CPUProfiler::buffer = nullptr;
+std::vector<CPUProfiler::ThreadBuffer*> CPUProfiler::buffers;
+std::mutex CPUProfiler::buffersMutex;
+const std::chrono::steady_clock::time_point CPUProfiler::startTime = std::chrono::steady_clock::now();
+
+long long CPUProfiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+//Buffers are never deleted, a thread may still be recording into its buffer while the game exits
+CPUProfiler::ThreadBuffer* CPUProfiler::threadBuffer()
+{
+	if (buffer == nullptr) {
+		ThreadBuffer* created = new ThreadBuffer();
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		created->id = (unsigned int)buffers.size();
+		buffers.push_back(created);
+		buffer = created;
+	}
+	return buffer;
+}
+
+void CPUProfiler::setThreadName(const char* name)
+{
+	ThreadBuffer* threadData = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	threadData->threadName = name;
+}
+
+//Once the buffer is full the oldest zone is overwritten
+//The zone is written before the count goes up, so writeTrace never sees a zone that is only half written
+void CPUProfiler::record(const char* name, long long start, long long end)
+{
+	ThreadBuffer* threadData = threadBuffer();
+	size_t index = threadData->written.load(std::memory_order_relaxed);
+	threadData->zones[index % zonesPerThread] = { name, start, end };
+	threadData->written.store(index + 1, std::memory_order_release);
+}
+
+//Can be called from any thread while the others carry on recording
+void CPUProfiler::writeTrace()
+{
+	std::ofstream file(tracePath, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		std::printf("Couldn't write the CPU trace to %s\n", tracePath);
+		return;
+	}
+	file << "{\"traceEvents\":[\n";
+	bool bFirst = true;
+	std::vector<Zone> zones;
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (ThreadBuffer* threadData : buffers) {
+		if (threadData->threadName != nullptr) {
+			file << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadData->id
+				<< ",\"args\":{\"name\":\"" << threadData->threadName << "\"}}";
+			bFirst = false;
+		}
+
+		//Copies the zones out first, the thread may overwrite the oldest ones while they're being copied
+		size_t end = threadData->written.load(std::memory_order_acquire);
+		size_t begin = end > zonesPerThread ? end - zonesPerThread : 0;
+		zones.clear();
+		for (size_t i = begin; i < end; i++) {
+			zones.push_back(threadData->zones[i % zonesPerThread]);
+		}
+		//Any zone the thread has lapped since the copy started is thrown away
+		//The fence stops the copy being moved after the second load, so the count read is at least as new as what was copied
+		std::atomic_thread_fence(std::memory_order_acquire);
+		size_t writtenAfter = threadData->written.load(std::memory_order_acquire);
+		//The thread writes a zone before it counts it, so zone writtenAfter may be half written, and it shares a slot with zone writtenAfter - zonesPerThread
+		size_t firstValid = writtenAfter + 1 > zonesPerThread ? writtenAfter + 1 - zonesPerThread : 0;
+		size_t skip = std::min(firstValid > begin ? firstValid - begin : 0, zones.size());
+
+		char event[256];
+		for (size_t i = skip; i < zones.size(); i++) {
+			const Zone& zone = zones[i];
+			//Chrome traces are in microseconds
+			std::snprintf(event, sizeof(event), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				zone.name, threadData->id, zone.start / 1000.0, (zone.end - zone.start) / 1000.0);
+			file << (bFirst ? "" : ",\n") << event;
+			bFirst = false;
+		}
+	}
+	file << "\n]}\n";
+	std::printf("CPU trace written to %s\n", tracePath);
+}
+#endif
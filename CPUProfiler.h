@@ -0,0 +1,73 @@
+#pragma once
+
+//Set to 0 (here or with the compiler's /D or -D option) to compile every profiler zone out of the game
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 1
+#endif
+
+#if CPU_PROFILER_ENABLED
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+//Records how long named parts of the code take on every thread, so a slow frame can be looked at after it has happened
+//Each thread writes its zones into its own ring buffer, so recording a zone never takes a lock or waits for another thread
+//The trace is written as Chrome trace event JSON, which can be opened in chrome://tracing or ui.perfetto.dev
+class CPUProfiler
+{
+public:
+	//Names the calling thread in the trace
+	static void setThreadName(const char* name);
+	//Writes the zones every thread has recorded to tracePath, only the newest zonesPerThread zones of each thread are kept
+	static void writeTrace();
+	static const char* const tracePath;
+
+	//Nanoseconds since the game started
+	static long long now();
+	//Adds a finished zone to the calling thread's buffer, name must be a string literal as only the pointer is kept
+	static void record(const char* name, long long start, long long end);
+
+private:
+	struct Zone {
+		const char* name;
+		long long start, end;
+	};
+	const static size_t zonesPerThread = 1 << 15;
+	struct ThreadBuffer {
+		Zone zones[zonesPerThread];
+		//How many zones have ever been recorded, the owning thread is the only one that changes it
+		std::atomic<size_t> written{ 0 };
+		const char* threadName = nullptr;
+		unsigned int id = 0;
+	};
+	//Creates the calling thread's buffer the first time it records anything
+	static ThreadBuffer* threadBuffer();
+
+	static thread_local ThreadBuffer* buffer;
+	//Every buffer ever created, the mutex is only taken when a thread creates its buffer and when the trace is written
+	static std::vector<ThreadBuffer*> buffers;
+	static std::mutex buffersMutex;
+	static const std::chrono::steady_clock::time_point startTime;
+};
+
+//Times the scope it's declared in, the zone is recorded when it goes out of scope
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name) : name(name), start(CPUProfiler::now()) {}
+	~ProfileZone() { CPUProfiler::record(name, start, CPUProfiler::now()); }
+private:
+	const char* name;
+	long long start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+//PROFILE_ZONE("name") times from where it is to the end of the enclosing block
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) CPUProfiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,70 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+//Class variables defined out of scope
+const float DynamicResolution::targetFrameMs = 14.f;
+const float DynamicResolution::raiseThreshold = 0.8f;
+const float DynamicResolution::minScale = 0.5f;
+const float DynamicResolution::maxScale = 1.f;
+const float DynamicResolution::scaleStep = 0.05f;
+bool DynamicResolution::bActive = false;
+float DynamicResolution::scale = 1.f;
+std::atomic<float> DynamicResolution::currentScale(1.f);
+unsigned long long DynamicResolution::latestSequence = 0;
+unsigned long long DynamicResolution::settledSequence = 0;
+float DynamicResolution::sampleTotal = 0.f;
+int DynamicResolution::sampleCount = 0;
+
+//The largest step up the scale can take at once, going up too quickly would just overshoot and have to come back down
+const float maxRaise = 0.1f;
+
+float DynamicResolution::update(bool bEnabled, unsigned long long sequence)
+{
+	latestSequence = sequence;
+	if (!bEnabled && scale != maxScale) {
+		scale = maxScale;
+		settledSequence = sequence;
+		sampleTotal = 0.f;
+		sampleCount = 0;
+	}
+	bActive = bEnabled;
+	currentScale = scale;
+	return scale;
+}
+
+void DynamicResolution::addFrameTime(unsigned long long sequence, float frameMs)
+{
+	if (!bActive || sequence < settledSequence) {
+		return;
+	}
+	sampleTotal += frameMs;
+	sampleCount++;
+	if (sampleCount < sampleFrames) {
+		return;
+	}
+	float averageMs = sampleTotal / sampleCount;
+	sampleTotal = 0.f;
+	sampleCount = 0;
+	if (averageMs <= 0.f || (averageMs <= targetFrameMs && averageMs >= targetFrameMs * raiseThreshold)) {
+		return;
+	}
+
+	//Most of the frame's cost is spent per pixel, and the number of pixels goes up with the square of the scale
+	float newScale = scale * std::sqrt(targetFrameMs / averageMs);
+	newScale = std::min(newScale, scale + maxRaise);
+	//Rounded down to a whole step, so a slow frame always drops at least one step
+	newScale = std::floor(newScale / scaleStep + 0.001f) * scaleStep;
+	newScale = std::min(std::max(newScale, minScale), maxScale);
+	if (newScale != scale) {
+		scale = newScale;
+		//The frames already in flight were drawn at the old size, their times don't say anything about the new one
+		settledSequence = latestSequence + 1;
+	}
+}
+
+float DynamicResolution::getCurrentScale()
+{
+	return currentScale;
+}
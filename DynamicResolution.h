@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+
+//Lowers the resolution the scene and bloom are drawn at when the GPU can't keep up, and raises it again once there's time to spare
+//The screen program stretches the smaller image over the whole window, the GUI is drawn after that so it always stays sharp
+//The GPU times come from the GPUProfiler, so if timer queries aren't supported the scale just stays at 1
+//Everything apart from getCurrentScale is called on the render thread
+class DynamicResolution
+{
+public:
+	//Called at the start of every frame, returns how much of the window's width and height this frame should be drawn at
+	//With bEnabled false the frame is always drawn at full size
+	static float update(bool bEnabled, unsigned long long sequence);
+	//Called with the GPU time of every frame as it's read back (a few frames after it was drawn)
+	static void addFrameTime(unsigned long long sequence, float frameMs);
+	//The scale the last frame was drawn at, can be called from any thread (the profiler overlay shows it)
+	static float getCurrentScale();
+
+	//The GPU time a frame should take (in milliseconds), a little under the 16.7 ms of a 60 fps frame so the odd slow frame doesn't miss it
+	const static float targetFrameMs;
+	//The scale only goes up once frames are this much quicker than the target, so it doesn't flick between two sizes
+	const static float raiseThreshold;
+	const static float minScale, maxScale;
+	//The scale moves in steps of this size, so the render size doesn't change by a pixel or two every few frames
+	const static float scaleStep;
+	//How many frames of GPU times are averaged before the scale is changed
+	const static int sampleFrames = 15;
+
+private:
+	static bool bActive;
+	static float scale;
+	static std::atomic<float> currentScale;
+	//Frames drawn before the last change were drawn at the old size, so only frames from settledSequence on are counted
+	static unsigned long long latestSequence, settledSequence;
+	static float sampleTotal;
+	static int sampleCount;
+};
@@ -0,0 +1,257 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <iostream>
+
+static bool isDepthFormat(GLenum format)
+{
+	return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F;
+}
+
+static bool sameDesc(const FrameGraphTextureDesc& a, const FrameGraphTextureDesc& b)
+{
+	return a.width == b.width && a.height == b.height && a.format == b.format;
+}
+
+void FrameGraph::beginFrame()
+{
+	resources.clear();
+	passCount = 0;
+	nextTimedPass = 0;
+	frameIndex++;
+}
+
+FrameGraphResource FrameGraph::createTexture(const FrameGraphTextureDesc& desc)
+{
+	resources.push_back({ desc, false, -1, -1, -1, false });
+	return (FrameGraphResource)resources.size() - 1;
+}
+
+FrameGraphResource FrameGraph::importBackbuffer()
+{
+	resources.push_back({ { 0, 0, 0 }, true, -1, -1, -1, false });
+	return (FrameGraphResource)resources.size() - 1;
+}
+
+//The passes are kept from frame to frame and written over, so their vectors stop allocating after the first frame
+void FrameGraph::addPass(const char* name, GPUPass timedAs, std::initializer_list<FrameGraphResource> reads, std::initializer_list<FrameGraphResource> writes, std::function<void()> run)
+{
+	if (passCount == (int)passes.size()) {
+		passes.emplace_back();
+	}
+	Pass& pass = passes[passCount++];
+	pass.name = name;
+	pass.timedAs = timedAs;
+	pass.reads.assign(reads.begin(), reads.end());
+	pass.writes.assign(writes.begin(), writes.end());
+	pass.run = std::move(run);
+	pass.bCulled = false;
+}
+
+//Works backwards from the screen, a pass is only needed if it draws to the screen or to a texture a needed pass reads
+void FrameGraph::cull()
+{
+	int culled = 0;
+	for (int i = passCount - 1; i >= 0; i--) {
+		Pass& pass = passes[i];
+		pass.bCulled = true;
+		for (FrameGraphResource write : pass.writes) {
+			if (resources[write].bBackbuffer || resources[write].bNeeded) {
+				pass.bCulled = false;
+			}
+		}
+		if (pass.bCulled) {
+			culled++;
+			continue;
+		}
+		for (FrameGraphResource read : pass.reads) {
+			resources[read].bNeeded = true;
+		}
+	}
+	culledPasses = culled;
+}
+
+//Each resource holds its pool texture from the first pass that uses it until the last, textures whose uses don't overlap share the same memory
+void FrameGraph::allocate()
+{
+	for (int i = 0; i < passCount; i++) {
+		if (passes[i].bCulled) {
+			continue;
+		}
+		for (const std::vector<FrameGraphResource>* uses : { &passes[i].reads, &passes[i].writes }) {
+			for (FrameGraphResource use : *uses) {
+				Resource& resource = resources[use];
+				if (resource.firstPass < 0) {
+					resource.firstPass = i;
+				}
+				resource.lastPass = i;
+			}
+		}
+	}
+	for (PooledTexture& pooled : pool) {
+		pooled.freeFromPass = 0;
+	}
+	//Given out in the order the passes run, so a texture freed by an earlier pass can go to a resource a later pass creates
+	for (int i = 0; i < passCount; i++) {
+		for (Resource& resource : resources) {
+			if (resource.firstPass == i && !resource.bBackbuffer) {
+				resource.pooled = acquireTexture(resource.desc, resource.firstPass, resource.lastPass);
+			}
+		}
+	}
+}
+
+int FrameGraph::acquireTexture(const FrameGraphTextureDesc& desc, int firstPass, int lastPass)
+{
+	for (int i = 0; i < (int)pool.size(); i++) {
+		if (sameDesc(pool[i].desc, desc) && pool[i].freeFromPass <= firstPass) {
+			pool[i].freeFromPass = lastPass + 1;
+			pool[i].lastUsedFrame = frameIndex;
+			return i;
+		}
+	}
+
+	PooledTexture pooled;
+	pooled.desc = desc;
+	pooled.freeFromPass = lastPass + 1;
+	pooled.lastUsedFrame = frameIndex;
+	glGenTextures(1, &pooled.texture);
+	glBindTexture(GL_TEXTURE_2D, pooled.texture);
+	if (isDepthFormat(desc.format)) {
+		glTexImage2D(GL_TEXTURE_2D, 0, desc.format, desc.width, desc.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	else {
+		glTexImage2D(GL_TEXTURE_2D, 0, desc.format, desc.width, desc.height, 0, GL_RGBA, GL_FLOAT, NULL);
+		//Linear filtering lets the bloom average 4 pixels in one fetch, and the screen program stretch a smaller frame over the window
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	pool.push_back(pooled);
+	return (int)pool.size() - 1;
+}
+
+GLuint FrameGraph::getFramebuffer(const Pass& pass)
+{
+	GLuint attachments[maxAttachments + 1] = {};
+	int colourCount = 0;
+	for (FrameGraphResource write : pass.writes) {
+		const Resource& resource = resources[write];
+		if (resource.bBackbuffer) {
+			return 0;
+		}
+		if (isDepthFormat(resource.desc.format)) {
+			attachments[maxAttachments] = pool[resource.pooled].texture;
+		}
+		else if (colourCount < maxAttachments) {
+			attachments[colourCount++] = pool[resource.pooled].texture;
+		}
+	}
+
+	for (CachedFramebuffer& cached : framebuffers) {
+		if (std::equal(attachments, attachments + maxAttachments + 1, cached.attachments)) {
+			cached.lastUsedFrame = frameIndex;
+			return cached.framebuffer;
+		}
+	}
+
+	CachedFramebuffer cached;
+	std::copy(attachments, attachments + maxAttachments + 1, cached.attachments);
+	cached.lastUsedFrame = frameIndex;
+	glGenFramebuffers(1, &cached.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, cached.framebuffer);
+	GLenum drawBuffers[maxAttachments];
+	for (int i = 0; i < colourCount; i++) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, attachments[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	if (attachments[maxAttachments] != 0) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, attachments[maxAttachments], 0);
+	}
+	//Which outputs of the fragment shader go to which texture is part of the framebuffer, so it only needs setting once
+	glDrawBuffers(colourCount, drawBuffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Framebuffer for the " << pass.name << " pass is incomplete" << std::endl;
+	}
+	framebuffers.push_back(cached);
+	return cached.framebuffer;
+}
+
+void FrameGraph::endTimedPasses(int pass)
+{
+	for (; nextTimedPass <= pass; nextTimedPass++) {
+		GPUProfiler::endPass((GPUPass)nextTimedPass);
+	}
+}
+
+void FrameGraph::execute()
+{
+	cull();
+	allocate();
+	for (int i = 0; i < passCount; i++) {
+		Pass& pass = passes[i];
+		if (pass.bCulled) {
+			continue;
+		}
+		endTimedPasses(pass.timedAs - 1);
+		glBindFramebuffer(GL_FRAMEBUFFER, getFramebuffer(pass));
+		pass.run();
+	}
+	endTimedPasses(GPU_PASS_COUNT - 1);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	freeUnused();
+}
+
+//Framebuffers go first, they can't be used once one of their textures has been deleted
+void FrameGraph::freeUnused()
+{
+	for (int i = (int)framebuffers.size() - 1; i >= 0; i--) {
+		bool bUnused = framebuffers[i].lastUsedFrame + unusedFramesBeforeFree < frameIndex;
+		for (const PooledTexture& pooled : pool) {
+			if (pooled.lastUsedFrame + unusedFramesBeforeFree < frameIndex && std::count(framebuffers[i].attachments, framebuffers[i].attachments + maxAttachments + 1, pooled.texture) > 0) {
+				bUnused = true;
+			}
+		}
+		if (bUnused) {
+			glDeleteFramebuffers(1, &framebuffers[i].framebuffer);
+			framebuffers.erase(framebuffers.begin() + i);
+		}
+	}
+	for (int i = (int)pool.size() - 1; i >= 0; i--) {
+		if (pool[i].lastUsedFrame + unusedFramesBeforeFree < frameIndex) {
+			glDeleteTextures(1, &pool[i].texture);
+			pool.erase(pool.begin() + i);
+		}
+	}
+
+	//Worked out here so the overlay can read it from the simulation thread
+	size_t bytes = 0;
+	for (const PooledTexture& pooled : pool) {
+		//Half floats are 2 bytes a channel, the depth textures are 24 bit but stored as 4 bytes
+		size_t pixelBytes = isDepthFormat(pooled.desc.format) ? 4 : 8;
+		bytes += (size_t)pooled.desc.width * pooled.desc.height * pixelBytes;
+	}
+	poolBytes = bytes;
+}
+
+GLuint FrameGraph::getTexture(FrameGraphResource resource) const
+{
+	if (resources[resource].bBackbuffer || resources[resource].pooled < 0) {
+		return 0;
+	}
+	return pool[resources[resource].pooled].texture;
+}
+
+size_t FrameGraph::getPoolBytes() const
+{
+	return poolBytes;
+}
+
+int FrameGraph::getCulledPassCount() const
+{
+	return culledPasses;
+}
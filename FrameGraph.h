@@ -0,0 +1,101 @@
+#pragma once
+#include "GPUProfiler.h"
+
+#include <GL/glew.h>
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+//A texture in the frame graph, only valid for the frame it was created in
+typedef int FrameGraphResource;
+
+struct FrameGraphTextureDesc {
+	int width, height;
+	GLenum format; //GL_RGBA16F for colour, GL_DEPTH_COMPONENT24 for depth
+};
+
+//Works out which framebuffers and textures each frame needs, instead of every one being made by hand at startup
+//Every frame the passes are added in the order they're drawn, each saying which textures it reads and which it draws to
+//execute then:
+//	Culls any pass whose output nothing (and eventually the screen) reads
+//	Gives each texture one from a pool, a pool texture is reused by a later texture of the same size once the last pass that reads the earlier one has run
+//	Binds a framebuffer with each pass's outputs attached and runs it
+//The pool and framebuffers are kept between frames, so after the first frame nothing is created unless the window changes size
+//Only used on the render thread, apart from getPoolBytes and getCulledPassCount
+class FrameGraph
+{
+public:
+	//Forgets the last frame's passes and textures (the pool's textures are kept)
+	void beginFrame();
+	//A texture that only lives for this frame, it isn't given an actual OpenGL texture until execute
+	FrameGraphResource createTexture(const FrameGraphTextureDesc& desc);
+	//The window's framebuffer, a pass that draws to it is never culled
+	FrameGraphResource importBackbuffer();
+	//Adds a pass that draws to writes (one framebuffer with each colour texture attached in order, and the depth texture if there is one)
+	//A pass that writes the backbuffer can't write anything else
+	//timedAs is the GPUProfiler pass its time is added to, run is called in execute with the outputs already bound
+	void addPass(const char* name, GPUPass timedAs, std::initializer_list<FrameGraphResource> reads, std::initializer_list<FrameGraphResource> writes, std::function<void()> run);
+	//Culls, allocates textures for, and runs every pass
+	void execute();
+
+	//The OpenGL texture behind a resource, only valid inside a pass's run function
+	GLuint getTexture(FrameGraphResource resource) const;
+	//How much memory the pool's textures take up (in bytes), and how many passes were culled last frame
+	//Both are kept from the end of the last execute, so they can be called from any thread (the profiler overlay shows them)
+	size_t getPoolBytes() const;
+	int getCulledPassCount() const;
+
+	//A pool texture (and any framebuffer it's attached to) is deleted once it's gone this many frames without being used, e.g. after the window is resized
+	const static int unusedFramesBeforeFree = 3;
+	const static int maxAttachments = 4;
+
+private:
+	struct Resource {
+		FrameGraphTextureDesc desc;
+		bool bBackbuffer;
+		//The first and last pass (that wasn't culled) to use it, and the pool texture it was given
+		int firstPass, lastPass;
+		int pooled;
+		//A pass that wasn't culled reads it
+		bool bNeeded;
+	};
+	struct Pass {
+		const char* name;
+		GPUPass timedAs;
+		std::vector<FrameGraphResource> reads, writes;
+		std::function<void()> run;
+		bool bCulled;
+	};
+	struct PooledTexture {
+		FrameGraphTextureDesc desc;
+		GLuint texture;
+		//The pass this frame from which it's free to be given to another resource
+		int freeFromPass;
+		unsigned long long lastUsedFrame;
+	};
+	struct CachedFramebuffer {
+		GLuint attachments[maxAttachments + 1]; //The colour textures then the depth texture, unused ones are 0
+		GLuint framebuffer;
+		unsigned long long lastUsedFrame;
+	};
+
+	void cull();
+	void allocate();
+	//Finds a free pool texture that matches desc, or makes a new one
+	int acquireTexture(const FrameGraphTextureDesc& desc, int firstPass, int lastPass);
+	GLuint getFramebuffer(const Pass& pass);
+	void freeUnused();
+	//Ends the GPUProfiler's timer for every pass up to and including pass, so a frame with no pass of a kind still writes its timestamp
+	void endTimedPasses(int pass);
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	int passCount = 0;
+	std::atomic<int> culledPasses{ 0 };
+	std::atomic<size_t> poolBytes{ 0 };
+	int nextTimedPass = 0;
+	unsigned long long frameIndex = 0;
+	std::vector<PooledTexture> pool;
+	std::vector<CachedFramebuffer> framebuffers;
+};
@@ -0,0 +1,130 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+//Class variables defined out of scope
+const float FramePacer::framePeriodMs = 1000.f / 60.f;
+const float FramePacer::safetyMarginMs = 2.f;
+const float FramePacer::costDecay = 0.05f;
+float FramePacer::audioLatencyMs = 0.f;
+std::mutex FramePacer::pacerMutex;
+FramePacer::Clock::time_point FramePacer::frameStart;
+FramePacer::Clock::time_point FramePacer::wakeTime;
+FramePacer::Clock::time_point FramePacer::lastDeadline;
+bool FramePacer::bHasDeadline = false;
+float FramePacer::buildMs = 0.f;
+float FramePacer::drawMs = 0.f;
+float FramePacer::gpuMs = 0.f;
+FramePacer::Clock::time_point FramePacer::lastPresent;
+bool FramePacer::bPresented = false;
+bool FramePacer::bVSync = false;
+float FramePacer::averageFrameLatencyMs = 0.f;
+unsigned int FramePacer::skippedDeadlines = 0;
+
+//How much each new frame moves the average latency
+const float latencySmoothing = 0.1f;
+
+typedef std::chrono::duration<float, std::milli> Milliseconds;
+
+//A slow frame is planned for straight away, but it takes a while of quicker frames before the estimate comes back down
+static void updateEstimate(float& estimate, float sample)
+{
+	estimate = sample > estimate ? sample : estimate + (sample - estimate) * FramePacer::costDecay;
+}
+
+void FramePacer::beginFrame()
+{
+	frameStart = Clock::now();
+}
+
+void FramePacer::endFrame()
+{
+	updateEstimate(buildMs, Milliseconds(Clock::now() - frameStart).count());
+}
+
+FramePacer::Clock::time_point FramePacer::scheduleNextFrame()
+{
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(Milliseconds(framePeriodMs));
+	Clock::time_point now = Clock::now();
+	Clock::time_point deadline = bHasDeadline ? lastDeadline + period : now + period;
+	float costMs;
+	{
+		std::lock_guard<std::mutex> lock(pacerMutex);
+		costMs = buildMs + drawMs + gpuMs + safetyMarginMs;
+		//With vsync the last frame was shown on one of the display's refreshes, so the deadline is moved onto the nearest refresh after it
+		//This stops the deadlines slowly drifting away from the display, without vsync frames are shown when they're finished so there's nothing to line up with
+		if (bPresented && bVSync) {
+			float periodsSincePresent = Milliseconds(deadline - lastPresent).count() / framePeriodMs;
+			deadline = lastPresent + std::chrono::duration_cast<Clock::duration>(Milliseconds(std::round(periodsSincePresent) * framePeriodMs));
+		}
+	}
+	Clock::duration cost = std::chrono::duration_cast<Clock::duration>(Milliseconds(costMs));
+	//Never aims two frames at the same deadline, the second would just replace the first
+	if (bHasDeadline && deadline <= lastDeadline) {
+		deadline += period;
+	}
+	//If there isn't time to make this deadline, the next one is aimed for instead
+	while (deadline - cost < now) {
+		deadline += period;
+		if (bHasDeadline) {
+			std::lock_guard<std::mutex> lock(pacerMutex);
+			skippedDeadlines++;
+		}
+	}
+	lastDeadline = deadline;
+	bHasDeadline = true;
+	wakeTime = deadline - cost;
+	return wakeTime;
+}
+
+void FramePacer::waitForWakeTime()
+{
+	std::this_thread::sleep_until(wakeTime);
+}
+
+void FramePacer::framePresented(Clock::time_point inputTime, float frameDrawMs, Clock::time_point presentTime)
+{
+	std::lock_guard<std::mutex> lock(pacerMutex);
+	updateEstimate(drawMs, frameDrawMs);
+	lastPresent = presentTime;
+	float latencyMs = Milliseconds(presentTime - inputTime).count();
+	averageFrameLatencyMs = bPresented ? averageFrameLatencyMs + (latencyMs - averageFrameLatencyMs) * latencySmoothing : latencyMs;
+	bPresented = true;
+}
+
+void FramePacer::addGPUFrameTime(float gpuFrameMs)
+{
+	std::lock_guard<std::mutex> lock(pacerMutex);
+	updateEstimate(gpuMs, gpuFrameMs);
+}
+
+void FramePacer::setVSync(bool bEnabled)
+{
+	std::lock_guard<std::mutex> lock(pacerMutex);
+	bVSync = bEnabled;
+}
+
+//The display shows the top of the frame first, so on average what's seen lags another half a refresh behind the swap
+void FramePacer::getSummary(std::vector<std::string>& lines)
+{
+	char line[64];
+	std::lock_guard<std::mutex> lock(pacerMutex);
+	std::snprintf(line, sizeof(line), "Pacing %.0f Hz, vsync %s", 1000.f / framePeriodMs, bVSync ? "on" : "off");
+	lines.push_back(line);
+	std::snprintf(line, sizeof(line), "Build %.2f Draw %.2f GPU %.2f", buildMs, drawMs, gpuMs);
+	lines.push_back(line);
+	if (bPresented) {
+		float scanoutMs = framePeriodMs * 0.5f;
+		std::snprintf(line, sizeof(line), "Latency ~%.1f ms", audioLatencyMs + averageFrameLatencyMs + scanoutMs);
+		lines.push_back(line);
+		std::snprintf(line, sizeof(line), " audio %.1f frame %.1f scan %.1f", audioLatencyMs, averageFrameLatencyMs, scanoutMs);
+		lines.push_back(line);
+	}
+	if (skippedDeadlines > 0) {
+		std::snprintf(line, sizeof(line), "Missed %u", skippedDeadlines);
+		lines.push_back(line);
+	}
+}
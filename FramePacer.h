@@ -0,0 +1,57 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Decides when the simulation should build each frame, so the frame is finished just in time for the display to show it
+//A fixed 16 ms timer drifts against the display and doesn't care how long frames take, so frames were shown anywhere up to a whole refresh after they were built
+//Instead, every frame has a deadline (a vsync) and the simulation wakes up as late as it can before that deadline, leaving just enough time to build and draw the frame
+//Waking up late means the pitch and the keys are read as close as possible to when the frame is seen, which is what makes the plane feel like it follows the singer
+//The deadlines are lined up with the times frames were actually shown (reported by the render thread), so they stay in step with the display
+class FramePacer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	//Called on the simulation thread when it wakes up, before any input is read, and once the frame has been published
+	static void beginFrame();
+	static void endFrame();
+	//When the simulation should wake up to build the next frame, also moves on to the next deadline
+	static Clock::time_point scheduleNextFrame();
+	//Sleeps until the time scheduleNextFrame returned, GLUT's timer only counts whole milliseconds so it's asked to wake up a little early
+	static void waitForWakeTime();
+
+	//Called on the render thread when a frame has been handed to the display
+	//inputTime is when the frame's input was read, drawMs is how long the render thread spent on it before swapping
+	static void framePresented(Clock::time_point inputTime, float drawMs, Clock::time_point presentTime);
+	//How long the GPU took over a frame (from the GPUProfiler), the GPU works on a frame after the render thread has finished with it so this adds to its cost
+	static void addGPUFrameTime(float gpuFrameMs);
+	//Whether the swap waits for vsync, set by the render thread
+	static void setVSync(bool bEnabled);
+
+	//Lines of text for the profiler overlay, can be called from any thread
+	static void getSummary(std::vector<std::string>& lines);
+
+	//The game is paced at 60 frames a second
+	const static float framePeriodMs;
+	//Extra time left before each deadline in case a frame takes longer than expected
+	const static float safetyMarginMs;
+	//How quickly the cost estimates fall after a slow frame (they rise straight away)
+	const static float costDecay;
+	//How long after the samples it's given the pitch is detected from, half the capture window (see AudioManager)
+	static float audioLatencyMs;
+
+private:
+	static std::mutex pacerMutex;
+	//Only used on the simulation thread
+	static Clock::time_point frameStart, wakeTime, lastDeadline;
+	static bool bHasDeadline;
+	static float buildMs;
+	//Written by the render thread and guarded by pacerMutex
+	static float drawMs, gpuMs;
+	static Clock::time_point lastPresent;
+	static bool bPresented, bVSync;
+	static float averageFrameLatencyMs;
+	static unsigned int skippedDeadlines;
+};
@@ -0,0 +1,163 @@
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+//The names of the passes as they're shown on the overlay and in the CSV header
+const char* const gpuPassNames[GPU_PASS_COUNT + 1] = { "Scene", "Bloom", "Composite", "GUI", "Frame" };
+
+//Class variables defined out of scope
+const char* const GPUProfiler::csvPath = "GPUTimings.csv";
+bool GPUProfiler::bSupported = false;
+bool GPUProfiler::bCreated = false;
+GLuint GPUProfiler::queries[profilerFrames][GPU_PASS_COUNT + 1];
+bool GPUProfiler::bIssued[profilerFrames] = {};
+bool GPUProfiler::bSlotRecording[profilerFrames] = {};
+unsigned long long GPUProfiler::slotSequence[profilerFrames] = {};
+int GPUProfiler::frameSlot = 0;
+bool GPUProfiler::bRecordingFrame = false;
+void (*GPUProfiler::frameCallback)(unsigned long long sequence, const float* passTimes) = nullptr;
+float GPUProfiler::history[GPU_PASS_COUNT + 1][historySize];
+int GPUProfiler::historyNext = 0;
+int GPUProfiler::historyCount = 0;
+unsigned int GPUProfiler::droppedFrames = 0;
+std::mutex GPUProfiler::historyMutex;
+std::ofstream GPUProfiler::csvFile;
+
+//Timestamp queries are part of OpenGL 3.3, older drivers may only have them as an extension or not at all
+void GPUProfiler::createQueries()
+{
+	bCreated = true;
+	bSupported = GLEW_ARB_timer_query || GLEW_VERSION_3_3;
+	if (!bSupported) {
+		std::printf("Timer queries aren't supported, GPU pass times won't be measured\n");
+		return;
+	}
+	glGenQueries(profilerFrames * (GPU_PASS_COUNT + 1), &queries[0][0]);
+}
+
+void GPUProfiler::beginFrame(bool bRecording, unsigned long long sequence)
+{
+	if (!bCreated) {
+		createQueries();
+	}
+	if (!bSupported) {
+		return;
+	}
+	//This slot's queries were issued profilerFrames frames ago, they have to be read before they can be reused
+	resolve(frameSlot);
+	bRecordingFrame = bRecording;
+	slotSequence[frameSlot] = sequence;
+	glQueryCounter(queries[frameSlot][0], GL_TIMESTAMP);
+}
+
+void GPUProfiler::endPass(GPUPass pass)
+{
+	if (!bSupported) {
+		return;
+	}
+	glQueryCounter(queries[frameSlot][pass + 1], GL_TIMESTAMP);
+}
+
+void GPUProfiler::endFrame()
+{
+	if (!bSupported) {
+		return;
+	}
+	bIssued[frameSlot] = true;
+	bSlotRecording[frameSlot] = bRecordingFrame;
+	frameSlot = (frameSlot + 1) % profilerFrames;
+}
+
+//The last query of a frame finishes last, so if it's available every query of that frame is
+void GPUProfiler::resolve(int slot)
+{
+	if (!bIssued[slot]) {
+		return;
+	}
+	bIssued[slot] = false;
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(queries[slot][GPU_PASS_COUNT], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (!bAvailable) {
+		std::lock_guard<std::mutex> lock(historyMutex);
+		droppedFrames++;
+		return;
+	}
+	GLuint64 timestamps[GPU_PASS_COUNT + 1];
+	for (int i = 0; i < GPU_PASS_COUNT + 1; i++) {
+		glGetQueryObjectui64v(queries[slot][i], GL_QUERY_RESULT, &timestamps[i]);
+	}
+	//Timestamps are in nanoseconds
+	float times[GPU_PASS_COUNT + 1];
+	for (int pass = 0; pass < GPU_PASS_COUNT; pass++) {
+		times[pass] = (float)(timestamps[pass + 1] - timestamps[pass]) / 1000000.f;
+	}
+	times[GPU_PASS_COUNT] = (float)(timestamps[GPU_PASS_COUNT] - timestamps[0]) / 1000000.f;
+
+	{
+		std::lock_guard<std::mutex> lock(historyMutex);
+		for (int pass = 0; pass < GPU_PASS_COUNT + 1; pass++) {
+			history[pass][historyNext] = times[pass];
+		}
+		historyNext = (historyNext + 1) % historySize;
+		historyCount = std::min(historyCount + 1, (int)historySize);
+	}
+	if (frameCallback != nullptr) {
+		frameCallback(slotSequence[slot], times);
+	}
+
+	if (bSlotRecording[slot]) {
+		//The file is only created the first time the overlay is shown, then every recorded frame is added to the end
+		if (!csvFile.is_open()) {
+			csvFile.open(csvPath, std::ios::out | std::ios::trunc);
+			for (int pass = 0; pass < GPU_PASS_COUNT + 1; pass++) {
+				csvFile << gpuPassNames[pass] << (pass < GPU_PASS_COUNT ? "," : "\n");
+			}
+		}
+		for (int pass = 0; pass < GPU_PASS_COUNT + 1; pass++) {
+			csvFile << times[pass] << (pass < GPU_PASS_COUNT ? "," : "\n");
+		}
+	}
+	else if (csvFile.is_open()) {
+		csvFile.flush();
+	}
+}
+
+void GPUProfiler::setFrameCallback(void (*callback)(unsigned long long sequence, const float* passTimes))
+{
+	frameCallback = callback;
+}
+
+const char* GPUProfiler::getPassName(int pass)
+{
+	return gpuPassNames[pass];
+}
+
+void GPUProfiler::getSummary(std::vector<std::string>& lines)
+{
+	float sorted[historySize];
+	char line[64];
+	std::lock_guard<std::mutex> lock(historyMutex);
+	std::snprintf(line, sizeof(line), "GPU ms      avg    p99");
+	lines.push_back(line);
+	if (historyCount == 0) {
+		lines.push_back(bSupported || !bCreated ? "Waiting for results" : "Timer queries not supported");
+		return;
+	}
+	for (int pass = 0; pass < GPU_PASS_COUNT + 1; pass++) {
+		float total = 0.f;
+		for (int i = 0; i < historyCount; i++) {
+			sorted[i] = history[pass][i];
+			total += sorted[i];
+		}
+		//Only the 99th percentile is needed, so the array is only partly sorted
+		int p99Index = std::min(historyCount - 1, (int)(historyCount * 0.99f));
+		std::nth_element(sorted, sorted + p99Index, sorted + historyCount);
+		std::snprintf(line, sizeof(line), "%-10s %5.2f  %5.2f", gpuPassNames[pass], total / historyCount, sorted[p99Index]);
+		lines.push_back(line);
+	}
+	if (droppedFrames > 0) {
+		std::snprintf(line, sizeof(line), "Dropped %u", droppedFrames);
+		lines.push_back(line);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//The parts of a frame that are timed on the GPU, in the order they're drawn
+enum GPUPass {
+	GPU_PASS_SCENE = 0,
+	GPU_PASS_BLOOM, //All of the bloom downsample and upsample passes
+	GPU_PASS_COMPOSITE,
+	GPU_PASS_GUI, //Drawn straight onto the screen at full resolution, after the composite
+	GPU_PASS_COUNT
+};
+
+//Measures how long each pass takes on the GPU with timestamp queries
+//A timestamp is recorded at the start of the frame and at the end of every pass, a pass's time is the difference between its timestamp and the one before it
+//The GPU runs behind the CPU, so a frame's queries are only read back when their slot comes round again (profilerFrames frames later)
+//If they still aren't ready that frame is dropped instead of waiting, so the profiler never stalls the render thread
+//Everything apart from getSummary is called on the render thread
+class GPUProfiler
+{
+public:
+	//bRecording is true while the overlay is showing, recorded frames are also written to the CSV file
+	//sequence is the number of the snapshot being drawn, it's handed to the frame callback with the frame's times
+	static void beginFrame(bool bRecording, unsigned long long sequence);
+	//Marks the end of a pass
+	static void endPass(GPUPass pass);
+	static void endFrame();
+
+	//Lines of text for the overlay, the rolling average and 99th percentile of each pass over the last historySize frames (in milliseconds)
+	//Can be called from any thread
+	static void getSummary(std::vector<std::string>& lines);
+	//Called on the render thread with the pass times of every frame as they're read back (GPU_PASS_COUNT + 1 of them, the last is the whole frame)
+	static void setFrameCallback(void (*callback)(unsigned long long sequence, const float* passTimes));
+	static const char* getPassName(int pass);
+
+	const static int historySize = 240;
+	static const char* const csvPath;
+	//How many frames the GPU can be behind before a frame's results are read (or dropped)
+	const static int profilerFrames = 3;
+
+private:
+	static void createQueries();
+	//Reads back the queries of a slot if they're ready and adds them to the history
+	static void resolve(int slot);
+
+	static bool bSupported, bCreated;
+	static GLuint queries[profilerFrames][GPU_PASS_COUNT + 1];
+	//True if the slot has queries waiting to be read, and if that frame should go in the CSV
+	static bool bIssued[profilerFrames], bSlotRecording[profilerFrames];
+	static unsigned long long slotSequence[profilerFrames];
+	static int frameSlot;
+	static bool bRecordingFrame;
+	static void (*frameCallback)(unsigned long long sequence, const float* passTimes);
+
+	//Times in milliseconds for the last historySize frames of each pass (the last entry is the whole frame)
+	static float history[GPU_PASS_COUNT + 1][historySize];
+	static int historyNext, historyCount;
+	static unsigned int droppedFrames;
+	static std::mutex historyMutex;
+	static std::ofstream csvFile;
+};
@@ -1,25 +1,50 @@
 #include "GUIManager.h"
+#include "CPUProfiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
 
 #include FT_FREETYPE_H
 
 //Similar to how a framebuffer is rendered onto a quad, so are characters, every character in a string is rendered to a quad and then has a texture applied over it
-GLuint VAO, VBO;
+GLuint VAO;
+//Every character is packed into this one texture, so a whole string (or every string) can be drawn with one draw call
+GLuint fontAtlas = 0;
+//How wide the font atlas is, it's as tall as it needs to be to fit every character
+const int fontAtlasWidth = 512;
 
 //A C++ Structure, stores details about every character that can be rendered to the screen
 //Every character in a font will have these details
 struct TypeChar {
-	GLuint TextureID;
 	glm::vec2 Size;
 	glm::vec2 Bearing;
 	unsigned int Advance;
+	//Where the character is in the font atlas, uvMin is its top left corner
+	glm::vec2 uvMin, uvMax;
 };
 
 //
 std::map<char, TypeChar> fontMap;
 std::vector<GUIObject*> guiRenderQueue;
 std::vector<Clickable*> clickChecks;
-//GUIShader is where the program id for the GUI Rendering shader is stored in OpenGL, isText is a uniform value telling the shader if it's rendering text or an image
-GLuint GUIshader, isTextPos;
+
+void GUIDrawList::add(GLuint texture, const GUIVertex* first, size_t count) {
+	if (count == 0) {
+		return;
+	}
+	if (batches.empty() || batches.back().texture != texture) {
+		batches.push_back({ texture, (unsigned int)vertices.size(), 0 });
+	}
+	vertices.insert(vertices.end(), first, first + count);
+	batches.back().vertexCount += (unsigned int)count;
+}
+
+void GUIDrawList::clear() {
+	vertices.clear();
+	batches.clear();
+}
 
 //Code that takes in a mouse location and outputs whether the click was within a clickable objects region
 bool Clickable::checkCollision(int mousePosX, int mousePosY) {
@@ -78,197 +103,276 @@ buttonGUI::buttonGUI(std::string inText, float inX, float inY, float inScale, GL
 }
 
 //Override for the ObjectGUI Render
-//Renders each character in a string, renders each character indivudally 
-void buttonGUI::Render() {
-	//Tell the GUI Shader Programme that I am rendering text
-	glProgramUniform1i(GUIshader, isTextPos, 1);
-	//If the text is being hovered over, set it to the hover colour, if not to the deafult colour
-	if (hovered) {
-		glUniform3f(glGetUniformLocation(GUIshader, "textColor"), hoverColour[0], hoverColour[1], hoverColour[2]);
-	}
-	else {
-		glUniform3f(glGetUniformLocation(GUIshader, "textColor"), colour[0], colour[1], colour[2]);
-	}
-
+//The string's vertices are made once and copied into the draw list every frame, they're only made again when the text or the colour changes
+void buttonGUI::Render(GUIDrawList& list) {
 	if (!enable) { //If the button is not enabled don't render it
 		return;
 	}
-	//Binds the information for drawing quads
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(VAO);
+	if (!bCacheValid || text != cachedText || hovered != bCachedHovered) {
+		//If the text is being hovered over, use the hover colour, if not the default colour
+		const GLfloat* textColour = hovered ? hoverColour : colour;
+		cachedVertices.clear();
+		//Buttons are centred on x, y
+		GUIManager::buildText(cachedVertices, text, x - advanceSum, y - (maxHeight / 2), scale, textColour);
+		cachedText = text;
+		bCachedHovered = hovered;
+		bCacheValid = true;
+	}
+	list.add(fontAtlas, cachedVertices.data(), cachedVertices.size());
+}
 
+void GUIManager::addText(GUIDrawList& list, const std::string& text, float x, float baselineY, float scale, const GLfloat colour[3]) {
+	//Kept between calls so the overlay doesn't allocate every frame, only called from the simulation thread
+	static std::vector<GUIVertex> vertices;
+	vertices.clear();
+	buildText(vertices, text, x, baselineY, scale, colour);
+	list.add(fontAtlas, vertices.data(), vertices.size());
+}
+
+//Adds two triangles for each character in the string, starting at x with the bottom of the text sitting on baselineY
+void GUIManager::buildText(std::vector<GUIVertex>& vertices, const std::string& text, float x, float baselineY, float scale, const GLfloat colour[3]) {
 	float charx = x;
 
 	std::string::const_iterator c;
 	for (c = text.begin(); c != text.end(); c++)
 	{
-		//The character struct for each character being rendered
-		TypeChar ch = fontMap[*c];
+		//The character struct for each character being rendered, characters the font doesn't have are skipped
+		std::map<char, TypeChar>::const_iterator found = fontMap.find(*c);
+		if (found == fontMap.end()) {
+			continue;
+		}
+		const TypeChar& ch = found->second;
 
-		float xpos = (charx - advanceSum) + ch.Bearing.x * scale;
-		float ypos = (y - (maxHeight / 2)) - (ch.Size.y - ch.Bearing.y) * scale;
+		float xpos = charx + ch.Bearing.x * scale;
+		float ypos = baselineY - (ch.Size.y - ch.Bearing.y) * scale;
 
 		float w = ch.Size.x * scale;
 		float h = ch.Size.y * scale;
 
-		// the Quad coordinates for each character being rendered
-		float vertices[6][4] = {
-			{ xpos,     ypos + h,   0.0f, 0.0f },
-			{ xpos,     ypos,       0.0f, 1.0f },
-			{ xpos + w, ypos,       1.0f, 1.0f },
+		// the Quad coordinates for each character being rendered, the UVs are the character's corner of the font atlas
+		float u0 = ch.uvMin.x, v0 = ch.uvMin.y, u1 = ch.uvMax.x, v1 = ch.uvMax.y;
+		GUIVertex quad[6] = {
+			{ xpos,     ypos + h,   u0, v0,   colour[0], colour[1], colour[2], 1.0f },
+			{ xpos,     ypos,       u0, v1,   colour[0], colour[1], colour[2], 1.0f },
+			{ xpos + w, ypos,       u1, v1,   colour[0], colour[1], colour[2], 1.0f },
 
-			{ xpos,     ypos + h,   0.0f, 0.0f },
-			{ xpos + w, ypos,       1.0f, 1.0f },
-			{ xpos + w, ypos + h,   1.0f, 0.0f }
+			{ xpos,     ypos + h,   u0, v0,   colour[0], colour[1], colour[2], 1.0f },
+			{ xpos + w, ypos,       u1, v1,   colour[0], colour[1], colour[2], 1.0f },
+			{ xpos + w, ypos + h,   u1, v0,   colour[0], colour[1], colour[2], 1.0f }
 		};
-		// render glyph texture over quad
-		glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-		// update content of VBO memory
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		// render quad
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		vertices.insert(vertices.end(), quad, quad + 6);
 		// now advance cursors for next glyph (note that advance is number of 1/64 pixels)
 		charx += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
 	}
-	//Clear the vertex array and the texture once finished rendering
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-//Simple constructor function for the ImageGUI class, loads in an image using the stbi image loader then buffers it to a texture
+//Simple constructor function for the ImageGUI class, loads in an image with the object loader (which uses the cooked texture if there is one)
 imageGUI::imageGUI(const char* imagePath, float inX, float inY, float inScale) {
 	posX = inX; posY = inY; scale = inScale;
 
-	stbi_set_flip_vertically_on_load(false);
-	int numChannels;
-	unsigned char* bytes = stbi_load(imagePath, &imgWidth, &imgHeight, &numChannels, 0);
-
-	glGenTextures(1, &texture);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imgWidth, imgHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
-
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(bytes);
+	//GUI images are drawn the right way up, if the texture comes back flipped the UVs are flipped instead
+	texture = AssetLoader::requestTexture(imagePath, false);
 }
 
-//Render Function for ImagGUI class, an override for the GUIObject class, very similar to rendering a quad for a character, but calculates the coordinates of the quad slightly differently
-void imageGUI::Render() {
-	glDisable(GL_DEPTH_TEST);
-	//Tell the GUI Program shader that I'm not rendering text and it should render an image
-	glProgramUniform1i(GUIshader, isTextPos, 0);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(VAO);
+//Render Function for ImagGUI class, an override for the GUIObject class, very similar to a quad for a character, but calculates the coordinates of the quad slightly differently
+void imageGUI::Render(GUIDrawList& list) {
+	if (!texture->loaded) {
+		return;
+	}
+	float h = (texture->height * scale) * 0.5f;
+	float w = (texture->width * scale) * 0.5f;
 
-	float h = (imgHeight * scale) * 0.5f;
-	float w = (imgWidth * scale) * 0.5f;
+	float vTop = texture->flipped ? 1.0f : 0.0f;
+	float vBottom = 1.0f - vTop;
 
-	float vertices[6][4] = {
-			{ posX - w,     posY + h,   0.0f, 0.0f },
-			{ posX - w,     posY - h,       0.0f, 1.0f },
-			{ posX + w , posY - h,       1.0f, 1.0f },
+	GUIVertex quad[6] = {
+		{ posX - w,     posY + h,   0.0f, vTop,      1.f, 1.f, 1.f, 0.f },
+		{ posX - w,     posY - h,       0.0f, vBottom,   1.f, 1.f, 1.f, 0.f },
+		{ posX + w , posY - h,       1.0f, vBottom,   1.f, 1.f, 1.f, 0.f },
 
-			{ posX - w,     posY + h,   0.0f, 0.0f },
-			{ posX + w, posY - h,       1.0f, 1.0f },
-			{ posX + w, posY + h,   1.0f, 0.0f }
+		{ posX - w,     posY + h,   0.0f, vTop,      1.f, 1.f, 1.f, 0.f },
+		{ posX + w, posY - h,       1.0f, vBottom,   1.f, 1.f, 1.f, 0.f },
+		{ posX + w, posY + h,   1.0f, vTop,      1.f, 1.f, 1.f, 0.f }
 	};
+	list.add(texture->id, quad, 6);
+}
 
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	// render quad
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+//A glyph that FreeType has rendered, kept on the CPU until the render thread can upload the atlas
+//atlasX and atlasY are where its top left pixel is in the font atlas
+struct GlyphBitmap {
+	unsigned int code;
+	int width, rows, left, top;
+	unsigned int advance;
+	int atlasX, atlasY;
+	std::vector<unsigned char> pixels;
+};
 
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glEnable(GL_DEPTH_TEST);
-}
+//Every glyph rendered from the font, packed into one single channel image
+struct GlyphAtlas {
+	std::vector<GlyphBitmap> glyphs;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+};
 
-//The setup function for the GUI Manager
-void GUIManager::Setup(GLuint program) {
-	//Uses FT to load fonts
+//Uses FT to load the font and render every glyph, this runs on a loading thread so no OpenGL calls are made here
+static void rasteriseGlyphs(std::vector<GlyphBitmap>& glyphs) {
 	FT_Library ft;
-	GUIshader = program;
-
-	if (FT_Init_FreeType(&ft)) { throw "Failed to open FT Library"; return; }
+	if (FT_Init_FreeType(&ft)) { std::cout << "Failed to open FT Library" << std::endl; return; }
 
 	FT_Face face;
-	if (FT_New_Face(ft, "fonts/arial.ttf", 0, &face)) { throw "Failed to open font"; return; }
+	if (FT_New_Face(ft, "fonts/arial.ttf", 0, &face)) { std::cout << "Failed to open font" << std::endl; FT_Done_FreeType(ft); return; }
 	FT_Set_Pixel_Sizes(face, 0, 48);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	
+
 	//Iterates over the unicode characters from 0-127, gives the basic ASCII character set
 	for (unsigned int c = 0; c < 128; c++) {
 		//Uses the FT library to load character for specific character
 		if (FT_Load_Char(face, c, FT_LOAD_RENDER)) { std::cout << "Failed to load glyph" << std::endl; continue; }
 
-		//Generate the texture for this specific character
-		GLuint texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
+		FT_Bitmap& bitmap = face->glyph->bitmap;
+		GlyphBitmap glyph;
+		glyph.code = c;
+		glyph.width = bitmap.width; //Width of the specific character (or glyph)
+		glyph.rows = bitmap.rows; //Height of the character
+		glyph.left = face->glyph->bitmap_left;
+		glyph.top = face->glyph->bitmap_top;
+		glyph.advance = face->glyph->advance.x;
+		//The bitmap belongs to FreeType and is overwritten by the next glyph, so it's copied out
+		glyph.pixels.assign(bitmap.buffer, bitmap.buffer + bitmap.width * bitmap.rows);
+		glyphs.push_back(glyph);
+	}
+	//Clears the buffer of the FT font loader library
+	FT_Done_Face(face);
+	FT_Done_FreeType(ft);
+}
+
+//Packs the glyphs into rows across the atlas (a new row is started when the next glyph doesn't fit), then copies them in
+//A pixel of space is left around every glyph, so linear filtering never blends in the edge of its neighbour
+static void packGlyphs(GlyphAtlas& atlas) {
+	const int padding = 1;
+	int x = padding, y = padding, rowHeight = 0;
+	for (GlyphBitmap& glyph : atlas.glyphs) {
+		if (x + glyph.width + padding > fontAtlasWidth) {
+			x = padding;
+			y += rowHeight + padding;
+			rowHeight = 0;
+		}
+		glyph.atlasX = x;
+		glyph.atlasY = y;
+		x += glyph.width + padding;
+		rowHeight = std::max(rowHeight, glyph.rows);
+	}
+	atlas.height = y + rowHeight + padding;
+	atlas.pixels.assign(fontAtlasWidth * atlas.height, 0);
+	for (GlyphBitmap& glyph : atlas.glyphs) {
+		for (int row = 0; row < glyph.rows; row++) {
+			std::memcpy(&atlas.pixels[(glyph.atlasY + row) * fontAtlasWidth + glyph.atlasX], &glyph.pixels[row * glyph.width], glyph.width);
+		}
+		//The glyph's pixels are in the atlas now
+		std::vector<unsigned char>().swap(glyph.pixels);
+	}
+}
+
+//The setup function for the GUI Manager
+//The font is rendered and packed on a loading thread, once it's ready the atlas is uploaded and the GUI scenes are created (they need the font to size their buttons)
+void GUIManager::Setup() {
+	std::shared_ptr<GlyphAtlas> atlas = std::make_shared<GlyphAtlas>();
+
+	AssetLoader::queueJob([atlas]() {
+		rasteriseGlyphs(atlas->glyphs);
+		packGlyphs(*atlas);
+	}, [atlas]() {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glGenTextures(1, &fontAtlas);
+		glBindTexture(GL_TEXTURE_2D, fontAtlas);
 		glTexImage2D(GL_TEXTURE_2D,
 			0,
-			GL_RED, //Characters don't have colour by default, so only need 1 Colour channel
-			face->glyph->bitmap.width, //Width of the specific character (or glyph)
-			face->glyph->bitmap.rows, //Height of the character
+			GL_R8, //Characters don't have colour by default, so only need 1 Colour channel
+			fontAtlasWidth,
+			atlas->height,
 			0,
 			GL_RED,
 			GL_UNSIGNED_BYTE,
-			face->glyph->bitmap.buffer //byte content of the image of the character (rendered similarly to an image)
+			atlas->pixels.data()
 		);
-		
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		
-		//Define the values for a structure 
-		TypeChar character = {
-			texture,
-			glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-			face->glyph->advance.x
-		};
-		//Insert the struct into a map so that properties about the character being rendered can be requested on rendering
-		fontMap.insert(std::pair<char, TypeChar>(c, character));
-	}
-	//Clears the buffer of the FT font loader library
-	FT_Done_Face(face);
-	FT_Done_FreeType(ft);
-	//Buffers a quad (similar to what happens in the Main Module
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-
-	guiRenderQueue = std::vector<GUIObject*>();
-	//Requests the uniform location of the isText bool in the GUI Shader
-	isTextPos = glGetUniformLocation(GUIshader, "isText");
-
-	//Creates all the GUI scenes
-	createMainMenu();
-	createOptionsMenu();
-	createGameGUI();
-	createScoreMenu();
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		float atlasWidth = (float)fontAtlasWidth, atlasHeight = (float)atlas->height;
+		for (const GlyphBitmap& glyph : atlas->glyphs) {
+			//Define the values for a structure 
+			TypeChar character = {
+				glm::ivec2(glyph.width, glyph.rows),
+				glm::ivec2(glyph.left, glyph.top),
+				glyph.advance,
+				glm::vec2(glyph.atlasX / atlasWidth, glyph.atlasY / atlasHeight),
+				glm::vec2((glyph.atlasX + glyph.width) / atlasWidth, (glyph.atlasY + glyph.rows) / atlasHeight)
+			};
+			//Insert the struct into a map so that properties about the character being rendered can be requested on rendering
+			fontMap.insert(std::pair<char, TypeChar>(glyph.code, character));
+		}
+
+		//The vertices are written into the render thread's stream buffer every frame, so the vertex array only needs the attributes turning on
+		glGenVertexArrays(1, &VAO);
+		glBindVertexArray(VAO);
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glBindVertexArray(0);
+
+		guiRenderQueue = std::vector<GUIObject*>();
+
+		//Creates all the GUI scenes
+		createMainMenu();
+		createOptionsMenu();
+		createGameGUI();
+		createScoreMenu();
+	});
+}
+
+GLuint GUIManager::getFontAtlas() {
+	return fontAtlas;
 }
 
 //Iterates over the guiRenderQueue and calls the render function of every GUI Element that is meant to be on screen
-void GUIManager::renderQueue() {
+void GUIManager::renderQueue(GUIDrawList& list) {
+	PROFILE_ZONE("GUIManager::renderQueue");
 	for (size_t i = 0; i < guiRenderQueue.size(); i++) {
 		if (guiRenderQueue[i]) {
-			guiRenderQueue[i]->Render();
+			guiRenderQueue[i]->Render(list);
 		}
 	}
 }
 
+//Draws each batch over the scene, the GUI shader should already be in use
+//A menu is usually a background image and then text, which is two draw calls
+void GUIManager::drawList(const GUIDrawList& list, StreamBuffer& stream) {
+	if (list.vertices.empty()) {
+		return;
+	}
+	GLintptr offset = stream.write(list.vertices.data(), list.vertices.size() * sizeof(GUIVertex), sizeof(GUIVertex));
+	if (offset < 0) {
+		return;
+	}
+
+	//Binds the information for drawing quads, each vertex is a vec4 of position and UV followed by a vec4 of colour and whether it's text
+	glActiveTexture(GL_TEXTURE0);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, stream.getBuffer());
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GUIVertex), (void*)offset);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GUIVertex), (void*)(offset + offsetof(GUIVertex, r)));
+	for (const GUIBatch& batch : list.batches) {
+		// render texture over the batch's quads
+		glBindTexture(GL_TEXTURE_2D, batch.texture);
+		glDrawArrays(GL_TRIANGLES, (GLint)batch.firstVertex, (GLsizei)batch.vertexCount);
+	}
+	//Clear the vertex array and the texture once finished rendering
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 //Called every time the mouse is moved or clicked
 //Iterates through every clickable GUI element in the scene, calls the onClick function if the mouse was clicked, sets hover to true if it was only hovered over
 void GUIManager::checkCollisions(int mousePosX, int mousePosY, bool clicked) {
@@ -303,6 +407,9 @@ buttonGUI* GUIManager::samplesOptionLeftClick = nullptr;
 buttonGUI* GUIManager::samplesOptionRightClick = nullptr;
 buttonGUI* GUIManager::samplesOptionText = nullptr;
 buttonGUI* GUIManager::samplesBackClick = nullptr;
+buttonGUI* GUIManager::bloomOptionLeftClick = nullptr;
+buttonGUI* GUIManager::bloomOptionRightClick = nullptr;
+buttonGUI* GUIManager::bloomOptionText = nullptr;
 
 std::vector<GUIObject*> GUIManager::optionsMenuVector = std::vector<GUIObject*>();
 std::vector<Clickable*> GUIManager::optionsMenuClickables = std::vector<Clickable*>();
@@ -353,6 +460,24 @@ void GUIManager::createOptionsMenu()
 		nullptr);
 	GUIManager::samplesOptionRightClick = samplesOptionRightClickTemp;
 
+	GUIObject* bloomQualityText = new buttonGUI("Bloom Quality", screenWidth / 2, 250.f, 1,
+		0.7f, 0.7f, 0.7f,
+		0.7f, 0.7f, 0.7f,
+		nullptr);
+	//The text is set to the chosen option by the OptionsManager
+	GUIManager::bloomOptionText = new buttonGUI("Medium", screenWidth / 2, 200.f, 1,
+		0.5f, 0.5f, 0.5f,
+		0.7f, 0.7f, 0.7f,
+		nullptr);
+	GUIManager::bloomOptionLeftClick = new buttonGUI("<", (screenWidth / 2) - 200.f, 200.f, 1,
+		0.5f, 0.5f, 0.5f,
+		0.7f, 0.7f, 0.7f,
+		nullptr);
+	GUIManager::bloomOptionRightClick = new buttonGUI(">", (screenWidth / 2) + 200.f, 200.f, 1,
+		0.5f, 0.5f, 0.5f,
+		0.7f, 0.7f, 0.7f,
+		nullptr);
+
 	buttonGUI* backButton = new buttonGUI("Back", screenWidth / 2, 100.f, 1,
 		0.5f, 0.5f, 0.5f,
 		0.7f, 0.7f, 0.7f,
@@ -365,9 +490,15 @@ void GUIManager::createOptionsMenu()
 	optionsMenuVector.push_back(samplesOptionText);
 	optionsMenuVector.push_back(samplesOptionLeftClick);
 	optionsMenuVector.push_back(samplesOptionRightClick);
+	optionsMenuVector.push_back(bloomQualityText);
+	optionsMenuVector.push_back(bloomOptionText);
+	optionsMenuVector.push_back(bloomOptionLeftClick);
+	optionsMenuVector.push_back(bloomOptionRightClick);
 
 	optionsMenuClickables.push_back(samplesOptionLeftClick);
 	optionsMenuClickables.push_back(samplesOptionRightClick);
+	optionsMenuClickables.push_back(bloomOptionLeftClick);
+	optionsMenuClickables.push_back(bloomOptionRightClick);
 	optionsMenuClickables.push_back(backButton);
 	
 }
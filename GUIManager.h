@@ -1,4 +1,6 @@
 #include "AudioManager.h";
+#include "AssetLoader.h"
+#include "StreamBuffer.h"
 
 #include <string>
 #include <glm/glm.hpp>
@@ -13,12 +15,38 @@
 #include <stb/stb_image.h>
 
 #pragma once
+//One corner of a GUI triangle, in screen coordinates
+//Text and images use the same vertex, the colour and whether it's text are part of it, so anything using the same texture can be drawn together
+struct GUIVertex {
+	float x, y, u, v;
+	float r, g, b;
+	float text; //1 for text (which only uses the red channel of the font atlas), 0 for images
+};
+
+//A run of the draw list's vertices that all use the same texture, drawn with one call
+struct GUIBatch {
+	GLuint texture;
+	unsigned int firstVertex, vertexCount;
+};
+
+//Everything the GUI draws in a frame, in the order it's drawn
+//GUI elements don't draw themselves, they add their vertices to the list in the frame's snapshot, which is drawn by the render thread
+//Every character is in the same texture (the font atlas), so all the text between two images goes into one batch
+struct GUIDrawList {
+	std::vector<GUIVertex> vertices;
+	std::vector<GUIBatch> batches;
+
+	//Adds the vertices to the last batch if it uses the same texture, otherwise starts a new batch
+	void add(GLuint texture, const GUIVertex* first, size_t count);
+	void clear();
+};
+
 //The GUI Object is the parent class of all GUI Elements
-//Contains the overridable function render, this is what is called by the GUIManager when rendering a frame
-//Most GUI elements will override this element, so by default it returns nothing
+//Contains the overridable function render, this is what is called by the GUIManager when building a frame
+//Most GUI elements will override this element, so by default it adds nothing
 class GUIObject {
 public:
-	virtual void Render() {
+	virtual void Render(GUIDrawList& /*list*/) {
 		return;
 	}
 };
@@ -48,13 +76,17 @@ private:
 	float advanceSum, x, y, scale, maxHeight;
 	GLfloat colour[3];
 	GLfloat hoverColour[3];
+	//The vertices for the whole string, only remade when the text (or whether it's hovered) changes
+	std::vector<GUIVertex> cachedVertices;
+	std::string cachedText;
+	bool bCachedHovered = false, bCacheValid = false;
 public:
 	//If a button is not enabled it will not be rendered, is enabled by default in the constructor, text stores the text that is rendered
 	bool enable;
 	std::string text;
 	//The constructor for the buttonGUI Class
 	buttonGUI(std::string inText, float inX, float inY, float inScale, GLfloat colR, GLfloat colG, GLfloat colB, GLfloat hovR, GLfloat hovG, GLfloat hovB, void (*f)());
-	void Render(); //Override for the GUIObject Render Function
+	void Render(GUIDrawList& list); //Override for the GUIObject Render Function
 };
 
 //The class for displaying Images, is a GUI element and so inherits from the GUI Element class
@@ -62,20 +94,29 @@ class imageGUI : public GUIObject {
 private:
 	//Properties about the image, location ID of image texture
 	float posX, posY, scale;
-	int imgHeight, imgWidth;
-	GLuint texture;
+	//Loaded in the background, the image isn't drawn until it has finished loading
+	TextureAsset* texture;
 public:
 	//Constructor function for image class
 	imageGUI(const char* imagePath, float inX, float inY, float inScale);
-	void Render(); //Override for GUIObject Render Function
+	void Render(GUIDrawList& list); //Override for GUIObject Render Function
 };
 
 //GUIManager controls all the GUI Elements rendered onto the screen
 class GUIManager
 {
 public:
-	static void Setup(GLuint program);
-	static void renderQueue(); //Called to render GUI onscreen
+	static void Setup();
+	static void renderQueue(GUIDrawList& list); //Called to add every GUI element on screen to the frame's draw list
+	//Draws a frame's draw list in order, each batch on top of the last (the depth test is off), called on the render thread with the GUI shader in use
+	//All the vertices are written into stream in one go (it has to have had beginFrame called this frame), then each batch is one draw call
+	static void drawList(const GUIDrawList& list, StreamBuffer& stream);
+	//Makes the vertices for a line of text, left aligned at x with the bottom of the text sitting on baselineY
+	static void buildText(std::vector<GUIVertex>& vertices, const std::string& text, float x, float baselineY, float scale, const GLfloat colour[3]);
+	//Adds a line of text straight to the draw list, for text that changes every frame (the profiler overlay)
+	static void addText(GUIDrawList& list, const std::string& text, float x, float baselineY, float scale, const GLfloat colour[3]);
+	//The texture every character is packed into, 0 until the font has loaded
+	static GLuint getFontAtlas();
 	static void checkCollisions(int mousePosX, int mousePosY, bool clicked); //Called to check if any element on the screen has been cliked
 
 	//Inititates all the Screens that are used in the programme, every GUIObject neeeds to exist to define its behaviour if clicked
@@ -110,6 +151,9 @@ public:
 	static buttonGUI* samplesOptionRightClick;
 	static buttonGUI* samplesOptionText;
 	static buttonGUI* samplesBackClick;
+	static buttonGUI* bloomOptionLeftClick;
+	static buttonGUI* bloomOptionRightClick;
+	static buttonGUI* bloomOptionText;
 	//Main Menu Buttons
 	static buttonGUI* MainMenu_StartButtonClick;
 	static buttonGUI* MainMenu_OptionsButtonClick;
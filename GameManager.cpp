@@ -6,9 +6,16 @@ int GameManager::score = 0;
 PlayerController* GameManager::currentPlayer = nullptr;
 std::string* GameManager::scoreStr = nullptr;
 bool GameManager::gamePlaying = false;
+float GameManager::songTime = 0.f;
+const float GameManager::maxSongDrift = 0.05f;
+bool GameManager::bSongAudio = true;
+float GameManager::songLength = 0.f;
+const float GameManager::songTail = 2.f;
+MemoryArena GameManager::songArena;
 
 const float GameManager::fovy = (45.f / 180.f) * glm::pi<float>();
 const float GameManager::dist = 60.f;
+const float GameManager::farPlane = 200.f;
 
 //The index of each note counting up from 0
 const std::map<std::string, int> notePairings{
@@ -29,7 +36,7 @@ const std::map<std::string, int> notePairings{
 //The function that loads the song file
 void GameManager::loadSongJson(const char* path, std::string& songTitle, Json::Value& notes)
 {
-	std::ifstream jsonFile(path);
+	std::ifstream jsonFile(AssetLoader::filePath(path));
 	Json::Value root;
 	jsonFile >> root;
 
@@ -49,38 +56,75 @@ void GameManager::startGame(const char* noteJsonPath, const char* noteSongPath,
 	*currentPlayer->playerScoreText = "0";
 
 	gamePlaying = true;
+	songTime = 0.f;
+	songLength = 0.f;
 
-	songSource = AudioManager();
-	ALuint songBuffer = songSource.addAudioBuffer(noteSongPath);
+	bSongAudio = noteSongPath != nullptr;
+	ALuint songBuffer = 0;
+	if (bSongAudio) {
+		songSource = AudioManager();
+		songBuffer = songSource.addAudioBuffer(AssetLoader::filePath(noteSongPath).c_str());
+	}
 
 	int x = notes.size();
-	//This loop places down all the notes in a file into the object manager queues so that they can be rendered and sent towards the player
+	//This loop places down all the notes in a file into the NoteField's chart, each note is sent towards the player once it's close enough to be seen
+	NoteField::Clear();
+	songArena.reset();
+	NoteField::beginChart(songArena, x);
+	NoteField::setViewHorizon(dist, farPlane);
 	for (int i = 0; i < x; i++) {
 		//Extracts 2 values about each note, it's value (to calculate how high on the screen it should be, and what time it should be played at)
 		std::string noteValue = notes[i][0].asCString();
 		float time = notes[i][1].asFloat();
-		int noteIndex = notePairings.at(noteValue);
+		int noteIndex = getNoteIndex(noteValue);
+		songLength = std::max(songLength, time + songTail);
 
 		float height = AudioManager::getHeightOfNote(noteIndex, fovy, dist);
 
-		DrawObject* noteObject = new NoteTarget(0.f, height, time, 1.f, 40.f, &songSource, player);
-		ObjectManager::addObjectToQueue(noteObject);
+		NoteField::addNote(time, height);
 	}
 	//Finally plays the song
-	songSource.playAudioBuffer(songBuffer);
+	if (bSongAudio) {
+		songSource.playAudioBuffer(songBuffer);
+	}
+}
+
+int GameManager::getNoteIndex(const std::string& noteName)
+{
+	return notePairings.at(noteName);
 }
 
-//Called every frame
-void GameManager::gameUpdate()
+//Called every simulation step
+//The audio's play position only changes when OpenAL updates it, so several steps in a row can see the same value
+//Instead the simulation keeps its own song time which moves by exactly one step each time, and only jumps to the audio's position if they drift too far apart
+void GameManager::gameUpdate(float step)
 {
-	float currentPlayPosition =  songSource.getPlayPos();
+	songTime += step;
+	bool bSongEnded;
+	if (bSongAudio) {
+		float currentPlayPosition = songSource.getPlayPos();
+		if (std::abs(songTime - currentPlayPosition) > maxSongDrift) {
+			songTime = currentPlayPosition;
+		}
+		bSongEnded = currentPlayPosition == 0 && songSource.startedPlaying == false;
+	}
+	else {
+		bSongEnded = songTime >= songLength;
+	}
 	//The code that checks if the game should finish
-	if (gamePlaying == true && currentPlayPosition == 0 && songSource.startedPlaying == false) {
+	if (gamePlaying == true && bSongEnded) {
 		gamePlaying = false;
+		//Throws away every note of the song in one go
+		NoteField::Clear();
+		songArena.reset();
 		//If the game is finished update the score screen and direct the player to it
 		GUIManager::scoreScreen_FinalScoreText->text = std::to_string(currentPlayer->playerScore);
 		GUIManager::showScoreMenu();
 	}
+	//Moves every note along and checks if the player has hit any of them
+	if (gamePlaying) {
+		NoteField::Update(songTime, currentPlayer);
+	}
 }
 
 
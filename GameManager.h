@@ -1,11 +1,13 @@
 #pragma once
 
 #include <json/json.h>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <string>
 
 #include "ObjectManager.h"
+#include "NoteField.h"
 #include "GUIManager.h"
 
 //Class that is responsible for controlling the game
@@ -17,18 +19,33 @@ private:
 	static PlayerController* currentPlayer;
 public:
 	static void loadSongJson(const char* path, std::string& songTitle, Json::Value& notes);
+	//If noteSongPath is nullptr nothing is played, the song's time is kept by the simulation alone and the song ends songTail seconds after the last note
 	static void startGame(const char* noteJsonPath, const char* noteSongPath, PlayerController* player);
-	static void gameUpdate();
+	//The index of a note's name ("A" is 0, "A#" is 1 and so on)
+	static int getNoteIndex(const std::string& noteName);
+	//Runs once every fixed simulation step
+	static void gameUpdate(float step);
 
 	//Properties about the field of view and the distance the camera is from the plane (player object)
 	const static float fovy;
 	const static float dist;
+	//How far the camera can see
+	const static float farPlane;
 
 	static int score;
 	static std::string* scoreStr;
 	static bool gamePlaying;
+	//The song's position as the simulation sees it, moved on by exactly one step each step and pulled back to the audio if they drift apart
+	static float songTime;
+	const static float maxSongDrift;
+	//False if the song is being played without audio (in the headless benchmark)
+	static bool bSongAudio;
+	static float songLength;
+	const static float songTail;
 
 	static AudioManager songSource;
+	//Everything that only lasts for one song is allocated from here, and it's all freed at once when the song ends
+	static MemoryArena songArena;
 
 };
 
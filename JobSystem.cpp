@@ -0,0 +1,162 @@
+#include "JobSystem.h"
+#include "CPUProfiler.h"
+
+#include <algorithm>
+
+//Class variables defined out of scope
+std::vector<std::thread> JobSystem::workers;
+std::vector<JobSystem::JobQueue*> JobSystem::queues;
+thread_local int JobSystem::threadIndex = -1;
+std::atomic<int> JobSystem::queuedJobs(0);
+std::mutex JobSystem::sleepMutex;
+std::condition_variable JobSystem::jobAvailable;
+bool JobSystem::bStopping = false;
+
+//The simulation thread and the render thread both have a core each, the workers get the rest
+//On a machine with 2 cores or fewer there are no workers and every job runs on the thread that waits for it
+void JobSystem::Start()
+{
+	bStopping = false;
+	unsigned int cores = std::thread::hardware_concurrency();
+	unsigned int workerCount = cores > 2 ? cores - 2 : 0;
+	for (unsigned int i = 0; i < workerCount + 1; i++) {
+		queues.push_back(new JobQueue());
+	}
+	threadIndex = 0;
+	for (unsigned int i = 1; i <= workerCount; i++) {
+		workers.push_back(std::thread(workerLoop, i));
+	}
+}
+
+//Any jobs still queued are thrown away
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		bStopping = true;
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	for (JobQueue* queue : queues) {
+		delete queue;
+	}
+	queues.clear();
+}
+
+unsigned int JobSystem::threadCount()
+{
+	return (unsigned int)std::max(queues.size(), (size_t)1);
+}
+
+unsigned int JobSystem::currentQueue()
+{
+	return threadIndex >= 0 ? (unsigned int)threadIndex : 0;
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter& counter)
+{
+	counter.count++;
+	//Before Start (or after Stop) there's nowhere to queue the job, so it's run straight away
+	if (queues.empty()) {
+		job();
+		counter.count--;
+		return;
+	}
+	JobQueue* queue = queues[currentQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back({ std::move(job), &counter });
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedJobs++;
+	}
+	jobAvailable.notify_one();
+}
+
+bool JobSystem::findJob(unsigned int index, Job& job)
+{
+	size_t queueCount = queues.size();
+	for (size_t i = 0; i < queueCount; i++) {
+		//Starts with this thread's own queue, then tries the others in turn
+		JobQueue* queue = queues[(index + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (queue->jobs.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			job = std::move(queue->jobs.back());
+			queue->jobs.pop_back();
+		}
+		else {
+			job = std::move(queue->jobs.front());
+			queue->jobs.pop_front();
+		}
+		queuedJobs--;
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::execute(Job& job)
+{
+	job.function();
+	job.counter->count--;
+}
+
+//The thread that's waiting helps with the work instead of sitting idle
+//If every queue is empty the jobs it's waiting on are running on other threads, so it just gives up the rest of its time slice
+void JobSystem::wait(JobCounter& counter)
+{
+	unsigned int index = currentQueue();
+	while (!counter.isDone()) {
+		Job job;
+		if (findJob(index, job)) {
+			execute(job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body)
+{
+	if (count == 0) {
+		return;
+	}
+	grainSize = std::max(grainSize, (size_t)1);
+	if (count <= grainSize || threadCount() == 1) {
+		body(0, count);
+		return;
+	}
+	//The first piece is kept back and run on this thread while the others are picked up
+	JobCounter counter;
+	for (size_t begin = grainSize; begin < count; begin += grainSize) {
+		size_t end = std::min(begin + grainSize, count);
+		run([&body, begin, end]() { body(begin, end); }, counter);
+	}
+	body(0, grainSize);
+	wait(counter);
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+	threadIndex = (int)index;
+	PROFILE_THREAD("Job worker");
+	while (true) {
+		Job job;
+		if (findJob(index, job)) {
+			execute(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		jobAvailable.wait(lock, [] { return bStopping || queuedJobs > 0; });
+		if (bStopping) {
+			return;
+		}
+	}
+}
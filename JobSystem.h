@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Counts how many jobs it's waiting on, goes up when a job is run with it and down when that job finishes
+//Work that depends on a group of jobs waits for their counter to reach 0
+struct JobCounter {
+	std::atomic<int> count{ 0 };
+	bool isDone() const { return count == 0; }
+};
+
+//Splits the simulation thread's per frame work over the other cores
+//Every thread has its own queue of jobs, a thread takes jobs from the back of its own queue (the newest, whose data is most likely still in the cache)
+//When its queue is empty it steals from the front of another thread's queue (the oldest, which is usually the biggest piece of work left)
+//Waiting on a counter runs other jobs instead of sleeping, so a job can wait on jobs it has started itself
+class JobSystem
+{
+public:
+	//Starts the workers, the thread calling Start becomes thread 0 (the simulation thread)
+	static void Start();
+	static void Stop();
+
+	//Queues job on the calling thread's queue, counter is counted down once it has run
+	static void run(std::function<void()> job, JobCounter& counter);
+	//Runs jobs (from any queue) until counter reaches 0
+	static void wait(JobCounter& counter);
+	//Calls body(begin, end) over 0 to count in pieces of about grainSize, and returns once every piece has finished
+	//If count is no more than grainSize body is just called on this thread, so small loops don't pay for the jobs
+	static void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+	//How many threads run jobs, including the simulation thread
+	static unsigned int threadCount();
+
+private:
+	struct Job {
+		std::function<void()> function;
+		JobCounter* counter;
+	};
+	struct JobQueue {
+		std::deque<Job> jobs;
+		std::mutex mutex;
+	};
+	static void workerLoop(unsigned int index);
+	//Takes a job from this thread's queue, or steals one from another, returns false if every queue was empty
+	static bool findJob(unsigned int index, Job& job);
+	static void execute(Job& job);
+	//Threads that aren't workers or the simulation thread (e.g. the render thread) share queue 0
+	static unsigned int currentQueue();
+
+	static std::vector<std::thread> workers;
+	static std::vector<JobQueue*> queues;
+	//Index of the calling thread's queue, -1 on threads the JobSystem didn't start
+	static thread_local int threadIndex;
+
+	//Workers sleep while there are no jobs queued
+	static std::atomic<int> queuedJobs;
+	static std::mutex sleepMutex;
+	static std::condition_variable jobAvailable;
+	static bool bStopping;
+};
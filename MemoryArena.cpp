@@ -0,0 +1,68 @@
+#include "MemoryArena.h"
+
+#include <cstdlib>
+
+const size_t MemoryArena::minimumBlockSize = 64 * 1024;
+
+MemoryArena::~MemoryArena()
+{
+	for (Block& block : blocks) {
+		std::free(block.memory);
+	}
+}
+
+void* MemoryArena::allocateBytes(size_t size, size_t alignment)
+{
+	if (!blocks.empty()) {
+		Block& block = blocks.back();
+		//Round the position up to the alignment, if it still fits the allocation is just a pointer bump
+		size_t start = (blockUsed + alignment - 1) & ~(alignment - 1);
+		if (start + size <= block.size) {
+			blockUsed = start + size;
+			return block.memory + start;
+		}
+		previousBlocksUsed += blockUsed;
+	}
+	//Out of space, so a new block is made, at least double the last one so this rarely happens
+	size_t blockSize = blocks.empty() ? minimumBlockSize : blocks.back().size * 2;
+	while (blockSize < size + alignment) {
+		blockSize *= 2;
+	}
+	Block block;
+	block.memory = (unsigned char*)std::malloc(blockSize);
+	if (block.memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	block.size = blockSize;
+	blocks.push_back(block);
+
+	//malloc only guarantees alignment for normal types, so the start is aligned by hand
+	size_t start = (alignment - ((size_t)block.memory & (alignment - 1))) & (alignment - 1);
+	blockUsed = start + size;
+	return block.memory + start;
+}
+
+void MemoryArena::reset()
+{
+	if (blocks.size() > 1) {
+		size_t totalSize = 0;
+		for (Block& block : blocks) {
+			totalSize += block.size;
+			std::free(block.memory);
+		}
+		blocks.clear();
+		Block block;
+		block.memory = (unsigned char*)std::malloc(totalSize);
+		if (block.memory != nullptr) {
+			block.size = totalSize;
+			blocks.push_back(block);
+		}
+	}
+	blockUsed = 0;
+	previousBlocksUsed = 0;
+}
+
+size_t MemoryArena::used() const
+{
+	return previousBlocksUsed + blockUsed;
+}
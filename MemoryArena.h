@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+//A monotonic arena: memory is handed out by moving a pointer forward through a large block, and is only ever freed all at once with reset
+//Used for everything that lives exactly as long as one song, so a song needs (at most) one real allocation and is torn down instantly
+//Only trivially destructible types should be allocated from it, since nothing's destructor is called on reset
+class MemoryArena
+{
+public:
+	MemoryArena() = default;
+	~MemoryArena();
+	MemoryArena(const MemoryArena&) = delete;
+	MemoryArena& operator=(const MemoryArena&) = delete;
+
+	//Allocates space for count values of T, aligned to at least 16 bytes so SSE can be used on the arrays
+	template <typename T>
+	T* allocate(size_t count)
+	{
+		T* values = (T*)allocateBytes(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+		for (size_t i = 0; i < count; i++) {
+			new (values + i) T();
+		}
+		return values;
+	}
+
+	//Frees everything allocated since the last reset
+	//The memory is kept for the next song, if more than one block was needed they're swapped for one block big enough for all of them
+	void reset();
+	//How many bytes are in use
+	size_t used() const;
+
+private:
+	void* allocateBytes(size_t size, size_t alignment);
+
+	struct Block {
+		unsigned char* memory;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	size_t blockUsed = 0; //How much of the last block is in use
+	size_t previousBlocksUsed = 0; //How much of every other block is in use
+
+	const static size_t minimumBlockSize;
+};
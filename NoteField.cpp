@@ -0,0 +1,356 @@
+#include "NoteField.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cstdio>
+
+const char* noteModelLocation = "Models\\newRedCube.obj";
+const char* noteTextureLocation = "Textures\\newRedNote.png";
+const char* noteHighlightModelLocation = "Models\\noteOutline.obj";
+const char* noteHighlightTextureLocation = "Textures\\green.png";
+
+const float NoteField::velocity = 40.f;
+const float NoteField::highlightTime = 1.f;
+const float NoteField::laneX = 0.f;
+
+//Size of the notes, and how far past the player a note can go before it is treated as missed
+const float noteScale = 2.f;
+const float noteDespawnZ = 40.f;
+//Half the size of a note's collision box on each axis (the same as a default CollisionBox)
+const CollisionBox noteCollision = CollisionBox(1.f, 1.f, 1.f);
+//How many notes each job moves in buildInstances (a multiple of 4 so every job can use SSE)
+const size_t notesPerJob = 1024;
+
+//Class variables defined out of scope
+size_t NoteField::noteCount = 0;
+size_t NoteField::noteCapacity = 0;
+size_t NoteField::firstLiveNote = 0;
+size_t NoteField::nextChartNote = 0;
+float NoteField::horizonTime = 5.f;
+float NoteField::lastPlayPos = 0.f;
+glm::vec3 NoteField::lastPlayerPos = glm::vec3(0.f);
+bool NoteField::bHasLastUpdate = false;
+float NoteField::tickPlayPos = 0.f;
+float NoteField::previousTickPlayPos = 0.f;
+float* NoteField::noteTime = nullptr;
+float* NoteField::noteHeight = nullptr;
+float* NoteField::noteZ = nullptr;
+float* NoteField::highlightOpacity = nullptr;
+unsigned char* NoteField::noteState = nullptr;
+NoteBatch NoteField::notes;
+NoteBatch NoteField::highlights;
+std::vector<glm::vec4> NoteField::cullSpheres;
+std::vector<unsigned char> NoteField::cullVisible;
+
+//Starts loading the models and textures used by notes, so they're ready before the first song starts
+void NoteField::Setup()
+{
+	notes.mesh = AssetLoader::requestMesh(noteModelLocation);
+	notes.texture = AssetLoader::requestTexture(noteTextureLocation);
+	notes.base = MatrixFunctions::scale(glm::vec3(noteScale, noteScale, noteScale));
+	notes.material = ObjectManager::addMaterial(1.f, 0.4f, true, 2.5f);
+
+	highlights.mesh = AssetLoader::requestMesh(noteHighlightModelLocation);
+	highlights.texture = AssetLoader::requestTexture(noteHighlightTextureLocation);
+	//The outline model faces the wrong way, so it's turned 90 degrees to face the camera
+	highlights.base = MatrixFunctions::rotateY(1.570796327f) * MatrixFunctions::scale(glm::vec3(noteScale, noteScale, noteScale));
+	highlights.material = ObjectManager::addMaterial(1.f, 1.f, false, 1.f);
+	highlights.bTranslucent = true;
+}
+
+//Every array needs room for the whole song, since a note keeps its index from when it's added until the song ends
+void NoteField::beginChart(MemoryArena& arena, size_t count)
+{
+	Clear();
+	noteCapacity = count;
+	noteTime = arena.allocate<float>(count);
+	noteHeight = arena.allocate<float>(count);
+	noteZ = arena.allocate<float>(count);
+	highlightOpacity = arena.allocate<float>(count);
+	noteState = arena.allocate<unsigned char>(count);
+	notes.instances = arena.allocate<glm::vec4>(count);
+	highlights.instances = arena.allocate<glm::vec4>(count);
+}
+
+//Forgets every note, called when a song ends
+//Nothing is freed here, the memory belongs to the arena
+void NoteField::Clear()
+{
+	noteCount = 0;
+	noteCapacity = 0;
+	firstLiveNote = 0;
+	nextChartNote = 0;
+	bHasLastUpdate = false;
+	noteTime = noteHeight = noteZ = highlightOpacity = nullptr;
+	noteState = nullptr;
+	notes.instances = highlights.instances = nullptr;
+	notes.instanceCount = highlights.instanceCount = 0;
+}
+
+//Adds a note, keeping the notes sorted by time
+//Song files are normally already in order, in which case the note just goes on the end
+void NoteField::addNote(float time, float height)
+{
+	if (noteCount >= noteCapacity) {
+		return;
+	}
+	size_t i = noteCount++;
+	while (i > 0 && noteTime[i - 1] > time) {
+		noteTime[i] = noteTime[i - 1];
+		noteHeight[i] = noteHeight[i - 1];
+		i--;
+	}
+	noteTime[i] = time;
+	noteHeight[i] = height;
+}
+
+//A note can be seen once it's closer to the camera than the far plane, so it needs to be live before its distance from the player is farPlane - cameraDist
+//The highlight appears highlightTime seconds early, so notes also need to be live by then
+void NoteField::setViewHorizon(float cameraDist, float farPlane)
+{
+	float viewDistance = farPlane - cameraDist + noteScale;
+	horizonTime = std::max(viewDistance / velocity, highlightTime);
+}
+
+//Makes notes live once they're within horizonTime of being played
+//The notes are sorted, so this stops at the first note that's still too far away
+void NoteField::activateNotes(float playPos)
+{
+	while (nextChartNote < noteCount && noteTime[nextChartNote] - playPos <= horizonTime) {
+		noteZ[nextChartNote] = (noteTime[nextChartNote] - playPos) * -velocity - noteScale;
+		highlightOpacity[nextChartNote] = 0.f;
+		noteState[nextChartNote] = NOTE_ACTIVE;
+		nextChartNote++;
+	}
+}
+
+//Retires live notes that are finished with, a note is finished once it has been hit or missed and its highlight has gone
+//Live notes are in time order, so only the notes at the front are checked, and retiring them just moves the start of the live run along
+void NoteField::retireNotes(float playPos)
+{
+	while (firstLiveNote < nextChartNote && noteState[firstLiveNote] != NOTE_ACTIVE && playPos > noteTime[firstLiveNote]) {
+		firstLiveNote++;
+	}
+}
+
+//Broadphase: live notes are sorted by time, so the only notes that could have reached the player since the last update are a short run of them
+//A note's z is (playPos - time) * velocity - scale, it's level with the player (|z| <= reach) when time is between playPos - (scale + reach) / velocity and playPos - (scale - reach) / velocity
+//Over the whole update this gives one range of times, which is found with two binary searches
+//Only those notes get the swept test, so the cost doesn't grow with the number of live notes
+void NoteField::checkHits(float playPos, PlayerController* player)
+{
+	glm::vec3 playerPos = glm::vec3(player->posX, player->posY, 0.f);
+	if (!bHasLastUpdate || lastPlayPos > playPos) {
+		lastPlayPos = playPos;
+		lastPlayerPos = playerPos;
+		bHasLastUpdate = true;
+	}
+
+	float reachZ = noteCollision.z + player->playerCollision.z;
+	float earliest = lastPlayPos - (noteScale + reachZ) / velocity;
+	float latest = playPos - (noteScale - reachZ) / velocity;
+	float* first = std::lower_bound(noteTime + firstLiveNote, noteTime + nextChartNote, earliest);
+	float* last = std::upper_bound(first, noteTime + nextChartNote, latest);
+
+	for (size_t i = first - noteTime; i < (size_t)(last - noteTime); i++) {
+		if (noteState[i] != NOTE_ACTIVE) {
+			continue;
+		}
+		glm::vec3 noteStart = glm::vec3(laneX, noteHeight[i], (lastPlayPos - noteTime[i]) * velocity - noteScale);
+		glm::vec3 noteEnd = glm::vec3(laneX, noteHeight[i], (playPos - noteTime[i]) * velocity - noteScale);
+		if (CollisionBox::sweptCollision(lastPlayerPos, playerPos, player->playerCollision, noteStart, noteEnd, noteCollision)) {
+			setNoteState(i, true, false, player);
+		}
+	}
+
+	lastPlayPos = playPos;
+	lastPlayerPos = playerPos;
+}
+
+//Changes the state of a note that has just been hit or has gone past the player
+//Only active notes can change, so a note can't be scored twice
+void NoteField::setNoteState(size_t i, bool hit, bool passed, PlayerController* player)
+{
+	if (noteState[i] != NOTE_ACTIVE) {
+		return;
+	}
+	if (hit) {
+		noteState[i] = NOTE_HIT;
+		player->playerScore += 100; //Increase score by 100
+		//Formatted into a buffer instead of with std::to_string, a score is short enough to fit inside the string without it allocating
+		char scoreBuffer[16];
+		int length = snprintf(scoreBuffer, sizeof(scoreBuffer), "%d", player->playerScore);
+		player->playerScoreText->assign(scoreBuffer, length);
+	}
+	else if (passed) {
+		noteState[i] = NOTE_MISSED;
+	}
+}
+
+//The same calculation as the SSE loop in Update, for the notes left over when the number of notes isn't a multiple of 4
+void NoteField::updateNote(size_t i, float playPos, PlayerController* player)
+{
+	//Calculate how close the note is based on the play position of the song
+	float z = (noteTime[i] - playPos) * -velocity - noteScale;
+	setNoteState(i, false, z > noteDespawnZ, player);
+}
+
+//One fixed simulation step: updates every live note in one pass, 4 at a time using SSE
+//Whether a note has gone past the player is worked out for all 4 notes at once as a mask, only notes whose bit is set need any more work
+void NoteField::Update(float playPos, PlayerController* player)
+{
+	previousTickPlayPos = bHasLastUpdate ? tickPlayPos : playPos;
+	tickPlayPos = playPos;
+
+	retireNotes(playPos);
+	activateNotes(playPos);
+	//Hits are checked before misses, so a note hit right as it passes the player still counts
+	checkHits(playPos, player);
+
+	size_t simdEnd = firstLiveNote + ((nextChartNote - firstLiveNote) & ~(size_t)3);
+
+	__m128 playPosV = _mm_set1_ps(playPos);
+	__m128 negVelocityV = _mm_set1_ps(-velocity);
+	__m128 scaleV = _mm_set1_ps(noteScale);
+	__m128 despawnV = _mm_set1_ps(noteDespawnZ);
+
+	for (size_t i = firstLiveNote; i < simdEnd; i += 4) {
+		__m128 timeV = _mm_loadu_ps(&noteTime[i]);
+
+		//z = (time - playPos) * -velocity - scale, the note has been missed once it's further than the despawn point
+		__m128 zV = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(timeV, playPosV), negVelocityV), scaleV);
+		int passedMask = _mm_movemask_ps(_mm_cmpgt_ps(zV, despawnV));
+
+		//Misses are rare, so the state is only touched when one of the 4 notes needs it
+		if (passedMask) {
+			for (int lane = 0; lane < 4; lane++) {
+				setNoteState(i + lane, false, (passedMask >> lane) & 1, player);
+			}
+		}
+	}
+	for (size_t i = simdEnd; i < nextChartNote; i++) {
+		updateNote(i, playPos, player);
+	}
+}
+
+//Works out where every live note is drawn this frame and fills the instance arrays
+//The frame is drawn somewhere between the last two simulation steps, so the play position is blended between them (alpha is how far between)
+//Nothing here changes the game, so the notes move smoothly however many steps ran this frame
+void NoteField::buildInstances(float alpha)
+{
+	float playPos = previousTickPlayPos + (tickPlayPos - previousTickPlayPos) * alpha;
+	size_t simdEnd = firstLiveNote + ((nextChartNote - firstLiveNote) & ~(size_t)3);
+
+	//Every note's position only depends on its own time, so long runs of notes are split between jobs
+	JobSystem::parallelFor(simdEnd - firstLiveNote, notesPerJob, [playPos](size_t begin, size_t end) {
+		__m128 playPosV = _mm_set1_ps(playPos);
+		__m128 negVelocityV = _mm_set1_ps(-velocity);
+		__m128 scaleV = _mm_set1_ps(noteScale);
+		__m128 despawnV = _mm_set1_ps(noteDespawnZ);
+		__m128 highlightTimeV = _mm_set1_ps(highlightTime);
+		__m128 zeroV = _mm_setzero_ps();
+		__m128 oneV = _mm_set1_ps(1.f);
+
+		for (size_t i = firstLiveNote + begin; i < firstLiveNote + end; i += 4) {
+			__m128 untilV = _mm_sub_ps(_mm_loadu_ps(&noteTime[i]), playPosV);
+
+			//z = (time - playPos) * -velocity - scale, clamped so it never goes further than the despawn point
+			__m128 zV = _mm_sub_ps(_mm_mul_ps(untilV, negVelocityV), scaleV);
+			_mm_storeu_ps(&noteZ[i], _mm_min_ps(zV, despawnV));
+
+			//Opacity = clamp((highlightTime - (time - playPos)) / highlightTime, 0, 1)
+			__m128 opacityV = _mm_div_ps(_mm_sub_ps(highlightTimeV, untilV), highlightTimeV);
+			_mm_storeu_ps(&highlightOpacity[i], _mm_min_ps(_mm_max_ps(opacityV, zeroV), oneV));
+		}
+	});
+	for (size_t i = simdEnd; i < nextChartNote; i++) {
+		float until = noteTime[i] - playPos;
+		noteZ[i] = std::min(until * -velocity - noteScale, noteDespawnZ);
+		//Opacity increases as the note gets closer to the player
+		highlightOpacity[i] = std::min(std::max((highlightTime - until) / highlightTime, 0.f), 1.f);
+	}
+
+	//Notes are drawn until they are hit or missed, highlights until the moment the note should have been hit
+	notes.instanceCount = 0;
+	highlights.instanceCount = 0;
+	for (size_t i = firstLiveNote; i < nextChartNote; i++) {
+		if (noteState[i] == NOTE_ACTIVE) {
+			notes.instances[notes.instanceCount++] = glm::vec4(laneX, noteHeight[i], noteZ[i], 1.f);
+		}
+		if (playPos <= noteTime[i]) {
+			highlights.instances[highlights.instanceCount++] = glm::vec4(laneX, noteHeight[i], 0.f, highlightOpacity[i]);
+		}
+	}
+}
+
+//Removes instances that can't be seen (notes far down the lane or ones that have flown past the camera)
+//Instances are only moved, so each one's bounding sphere is the mesh's sphere turned and scaled by the base, then moved to the instance
+void NoteField::cullBatch(NoteBatch& batch)
+{
+	glm::vec3 centerOffset = glm::vec3(batch.base * glm::vec4(batch.mesh->boundsCenter, 1.f));
+	float radius = batch.mesh->boundsRadius * noteScale;
+	cullSpheres.resize(batch.instanceCount);
+	cullVisible.resize(batch.instanceCount);
+	for (size_t i = 0; i < batch.instanceCount; i++) {
+		cullSpheres[i] = glm::vec4(glm::vec3(batch.instances[i]) + centerOffset, radius);
+	}
+	ObjectManager::cullSpheres(cullSpheres.data(), batch.instanceCount, cullVisible.data());
+
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < batch.instanceCount; i++) {
+		if (cullVisible[i]) {
+			batch.instances[visibleCount++] = batch.instances[i];
+		}
+	}
+	ObjectManager::countCulled(batch.instanceCount - visibleCount, visibleCount);
+	batch.instanceCount = visibleCount;
+}
+
+bool NoteField::isBatchReady(NoteBatch& batch)
+{
+	return batch.instanceCount > 0 && batch.mesh->loaded && batch.texture->loaded;
+}
+
+//Draws a batch with a single instanced draw call
+//The instances are copied into the frame's snapshot, the render thread draws them with the mesh's instanced vertex array (attribute 3 is advanced once per instance)
+//The batch uses the camera as its modelview, each instance is moved into place in the vertex shader
+void NoteField::drawBatch(NoteBatch& batch, const glm::mat4& view)
+{
+	if (batch.instanceCount == 0) {
+		return;
+	}
+
+	//Every instance is on the same lane, so the lane's distance from the camera is used as the batch's depth
+	float viewDepth = -(view * glm::vec4(laneX, 0.f, 0.f, 1.f)).z;
+	RenderCommand command;
+	command.key = ObjectManager::makeSortKey(batch.bTranslucent, batch.texture->id, batch.mesh->VertexArrayID, viewDepth);
+	command.texture = batch.texture->id;
+	command.VertexArrayID = batch.mesh->VertexArrayID;
+	command.vertexCount = batch.mesh->vertexCount;
+	command.instanceCount = (GLsizei)batch.instanceCount;
+	command.firstInstance = ObjectManager::pushInstances(batch.instances, batch.instanceCount);
+	command.mesh = batch.mesh;
+	command.objectSlot = ObjectManager::pushObjectData(view, batch.material, &batch.base);
+	ObjectManager::submit(command);
+}
+
+//A batch whose mesh or texture is still loading is emptied, so Draw skips it
+void NoteField::prepareDraw(float alpha)
+{
+	buildInstances(alpha);
+	for (NoteBatch* batch : { &notes, &highlights }) {
+		if (isBatchReady(*batch)) {
+			cullBatch(*batch);
+		}
+		else {
+			batch->instanceCount = 0;
+		}
+	}
+}
+
+//The highlights are see-through, so they're sorted after the opaque notes and the rest of the scene
+void NoteField::Draw(const glm::mat4& view)
+{
+	drawBatch(notes, view);
+	drawBatch(highlights, view);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "ObjectManager.h"
+#include "MemoryArena.h"
+
+#include <vector>
+
+//The state of a single note in the NoteField
+enum NoteState : unsigned char {
+	NOTE_ACTIVE = 0, //Still flying towards the player
+	NOTE_HIT = 1, //The player flew through it
+	NOTE_MISSED = 2 //It went past the player without being hit
+};
+
+//A group of notes that are drawn with one instanced draw call (all the notes, or all the highlights)
+//Each instance is a vec4, xyz is where the instance is and w is its opacity
+struct NoteBatch {
+	MeshAsset* mesh = nullptr;
+	TextureAsset* texture = nullptr;
+	glm::mat4 base = glm::mat4(1.f); //Rotation and scale shared by every instance
+	int material = 0;
+	bool bTranslucent = false; //True if the instances fade in and out
+	//Allocated from the song's arena with room for every note, so filling it never allocates
+	glm::vec4* instances = nullptr;
+	size_t instanceCount = 0;
+};
+
+//The NoteField holds the notes of the current song
+//Every property of a note is kept in its own contiguous array (a structure of arrays), sorted by time
+//A note is only made live when it's about to come into view, the live notes are always a run of the arrays (firstLiveNote up to nextChartNote)
+//This means one pass over that run updates every live note, and 4 notes can be updated at once with SSE instructions
+//All the arrays are allocated from the song's MemoryArena in beginChart, and are thrown away with it when the song ends
+class NoteField
+{
+public:
+	static void Setup();
+	//Allocates room for noteCount notes from the arena, addNote can then be called up to noteCount times
+	static void beginChart(MemoryArena& arena, size_t noteCount);
+	//Forgets every note, the arena they were allocated from should be reset afterwards
+	static void Clear();
+	static void addNote(float time, float height);
+	//Works out how far ahead of the song notes need to be made live, from how far the camera is behind the player and how far it can see
+	static void setViewHorizon(float cameraDist, float farPlane);
+	//Runs once every fixed simulation step
+	//Makes notes that have come into view live and retires ones that have gone past, then checks every live note for hits and misses
+	static void Update(float playPos, PlayerController* player);
+	//Moves and fades the notes to where they are alpha of the way between the last two steps, then culls them
+	//Only touches the NoteField, so it's run as a job while the ObjectManager prepares the rest of the scene
+	static void prepareDraw(float alpha);
+	//Adds a draw command for each batch prepared by prepareDraw
+	static void Draw(const glm::mat4& view);
+
+	//How fast the notes travel towards the player and how early the highlights start to appear (in seconds)
+	const static float velocity;
+	const static float highlightTime;
+	//The x position of the lane every note travels down
+	const static float laneX;
+
+private:
+	static void updateNote(size_t i, float playPos, PlayerController* player);
+	static void setNoteState(size_t i, bool hit, bool passed, PlayerController* player);
+	static bool isBatchReady(NoteBatch& batch);
+	static void cullBatch(NoteBatch& batch);
+	static void drawBatch(NoteBatch& batch, const glm::mat4& view);
+	static void activateNotes(float playPos);
+	static void retireNotes(float playPos);
+	static void checkHits(float playPos, PlayerController* player);
+	static void buildInstances(float alpha);
+
+	//How many notes have been added and how many there's room for
+	static size_t noteCount, noteCapacity;
+	//Notes before firstLiveNote are finished with, notes from nextChartNote on haven't been made live yet
+	static size_t firstLiveNote, nextChartNote;
+	//How many seconds before its time a note is made live
+	static float horizonTime;
+
+	//Where the song and the player were last update, so hits are checked along the whole path taken since then
+	static float lastPlayPos;
+	static glm::vec3 lastPlayerPos;
+	static bool bHasLastUpdate;
+	//The play position at the last two simulation steps, rendering blends between them
+	static float tickPlayPos, previousTickPlayPos;
+
+	//One entry per note (in time order), index i in every array is the same note
+	//noteZ and highlightOpacity are where the note is drawn this frame
+	static float *noteTime, *noteHeight, *noteZ, *highlightOpacity;
+	static unsigned char* noteState;
+
+	static NoteBatch notes, highlights;
+	//Scratch space for culling, it only grows so it stops allocating after the first few frames
+	static std::vector<glm::vec4> cullSpheres;
+	static std::vector<unsigned char> cullVisible;
+};
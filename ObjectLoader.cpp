@@ -2,6 +2,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "ObjectLoader.h"
 
+#include <iostream>
+#include <cstring>
+
 //This class takes in a wavefront file path as an argument
 //The program decodes the wavefront file and outputs 3 vectors.
 //Each vector has a size a multiple of 3, every 3 is a face that needs to be rendered and each vector contains details about where that face should be, how to texture it and which way it should be facing for lighting calculations
@@ -20,6 +23,10 @@ bool ObjectLoader::loadOBJ(const char* path, std::vector<glm::vec3>& out_vertice
 		while (std::getline(data, instruction, ' ')) {
 			splitData.push_back(instruction);
 		}
+		//Blank lines have nothing to decode
+		if (splitData.empty()) {
+			continue;
+		}
 		//If the first word of the line is a v we know it is describing a vertex
 		//Isolates the vertex information and adds it to the vertex array
 		if (splitData[0] == "v") {
@@ -75,23 +82,103 @@ bool ObjectLoader::loadOBJ(const char* path, std::vector<glm::vec3>& out_vertice
 }
 
 //Loads a texture file, buffers it into openGL and then returns the texture ID
-//This function uses stbi to load png files.
+//3D objects always want their textures flipped (OpenGL expects the first row of pixels to be the bottom of the image)
 GLuint ObjectLoader::loadTexture(const char* path)
 {
-	GLuint retTexture;
-	stbi_set_flip_vertically_on_load(true);
-	int imgWidth, imgHeight, numChannels;
+	int imgWidth, imgHeight;
+	bool flipped;
+	return loadTexture(path, true, imgWidth, imgHeight, flipped);
+}
+
+//Decodes and uploads a texture straight away, the texture is ready to use as soon as this returns
+GLuint ObjectLoader::loadTexture(const char* path, bool flipVertically, int& outWidth, int& outHeight, bool& outFlipped)
+{
+	TextureData data;
+	if (!decodeTexture(path, flipVertically, data)) {
+		outWidth = 0; outHeight = 0; outFlipped = false;
+		return 0;
+	}
+	return uploadTexture(data, outWidth, outHeight, outFlipped);
+}
+
+//If the texture has been cooked (see TextureCooker) and the png hasn't changed since, the cooked file is mapped, it already contains every mip level
+//Otherwise this function uses stbi to load png files.
+//Nothing in here touches OpenGL, so the loading threads can call it
+bool ObjectLoader::decodeTexture(const char* path, bool flipVertically, TextureData& out)
+{
+	out.flipVertically = flipVertically;
+	if (TextureCooker::openCookedTexture(TextureCooker::cookedPathFor(path).c_str(), path, out.cooked)) {
+		out.isCooked = true;
+		return true;
+	}
+
+	//Read the header first so images without an alpha channel can be loaded as RGB, anything else is expanded to RGBA
+	int numChannels;
+	if (!stbi_info(path, &out.width, &out.height, &numChannels)) {
+		std::cout << "Failed to load texture: " << path << std::endl;
+		return false;
+	}
+	out.channels = numChannels == 3 ? 3 : 4;
 	//Opens the images file in raw byte form, also returns information about image height, width and the number of colour channels in the image
-	unsigned char* bytes = stbi_load(path, &imgWidth, &imgHeight, &numChannels, 0);
+	out.pixels = stbi_load(path, &out.width, &out.height, &numChannels, out.channels);
+	if (!out.pixels) {
+		std::cout << "Failed to load texture: " << path << std::endl;
+		return false;
+	}
+
+	//stbi's flip setting is shared by every thread, so the rows are flipped here instead of with stbi_set_flip_vertically_on_load
+	if (flipVertically) {
+		int rowSize = out.width * out.channels;
+		std::vector<unsigned char> row(rowSize);
+		for (int y = 0; y < out.height / 2; y++) {
+			unsigned char* top = out.pixels + y * rowSize;
+			unsigned char* bottom = out.pixels + (out.height - 1 - y) * rowSize;
+			std::memcpy(row.data(), top, rowSize);
+			std::memcpy(top, bottom, rowSize);
+			std::memcpy(bottom, row.data(), rowSize);
+		}
+	}
+	return true;
+}
+
+//Buffers a decoded texture into OpenGL and returns the texture ID, must be called on the thread that owns the OpenGL context
+GLuint ObjectLoader::uploadTexture(TextureData& data, int& outWidth, int& outHeight, bool& outFlipped)
+{
+	if (data.isCooked) {
+		bool cookedFlipped;
+		GLuint cookedTexture = TextureCooker::uploadCookedTexture(data.cooked, outWidth, outHeight, cookedFlipped);
+		data.isCooked = false;
+		outFlipped = cookedFlipped != data.flipVertically;
+		return cookedTexture;
+	}
+	outFlipped = false;
+	outWidth = data.width;
+	outHeight = data.height;
+
+	GLuint retTexture;
+	GLenum format = data.channels == 3 ? GL_RGB : GL_RGBA;
 
 	//Generate the texture and then buffer in the loaded image
 	glGenTextures(1, &retTexture);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, retTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imgWidth, imgHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
+	//RGB rows aren't always a multiple of 4 bytes long, so tell OpenGL the rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, data.channels == 3 ? GL_RGB8 : GL_RGBA8, data.width, data.height, 0, format, GL_UNSIGNED_BYTE, data.pixels);
 
 	glGenerateMipmap(GL_TEXTURE_2D);
 	//Explicitly free the memory because it isn't needed anymore and can take up a lot of memory if not explicitly cleared
-	stbi_image_free(bytes);
+	stbi_image_free(data.pixels);
+	data.pixels = nullptr;
 	return retTexture;
 }
+
+void ObjectLoader::freeTexture(TextureData& data)
+{
+	if (data.isCooked) {
+		TextureCooker::unmapFile(data.cooked);
+		data.isCooked = false;
+	}
+	stbi_image_free(data.pixels);
+	data.pixels = nullptr;
+}
@@ -9,6 +9,17 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <stb/stb_image.h>
+#include "TextureCooker.h"
+
+//A texture that has been read from disk but not given to OpenGL yet
+//Either the cooked file is mapped into memory, or the png has been decoded into pixels
+struct TextureData {
+    MappedFile cooked;
+    bool isCooked = false;
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0, channels = 0;
+    bool flipVertically = true;
+};
 
 //The class that is reponsible for loading wavefront files and buffering textures into OpenGL
 class ObjectLoader
@@ -24,5 +35,33 @@ public:
     static GLuint loadTexture(
         const char* path
     );
+
+    //flipVertically is the orientation the caller wants, outFlipped is set to true if the texture loaded the other way up (a cooked texture is always cooked one way)
+    static GLuint loadTexture(
+        const char* path,
+        bool flipVertically,
+        int& outWidth,
+        int& outHeight,
+        bool& outFlipped
+    );
+
+    //loadTexture split into the part that reads the file (safe to call from a loading thread) and the part that needs OpenGL
+    static bool decodeTexture(
+        const char* path,
+        bool flipVertically,
+        TextureData& out
+    );
+
+    static GLuint uploadTexture(
+        TextureData& data,
+        int& outWidth,
+        int& outHeight,
+        bool& outFlipped
+    );
+
+    //Frees a decoded texture that is never going to be uploaded
+    static void freeTexture(
+        TextureData& data
+    );
 };
 
@@ -1,21 +1,41 @@
 #include "ObjectManager.h"
+#include "NoteField.h"
+#include "RenderThread.h"
+#include "CPUProfiler.h"
 
-std::vector<DrawObject*> objRenderQueue;
-glm::mat4 objModelview;
+#include <algorithm>
+#include <cstring>
+#include <xmmintrin.h>
+
+//The camera, it never moves
+glm::mat4 objModelview = glm::lookAt(glm::vec3(0, 0, 60.f), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
 glm::mat4 objIdentity = glm::mat4(1.f);
 std::vector <glm::mat4> objModelviewStack;
-GLuint objModelviewPos, opacityPos, ambientPos, bloomPos, brightnessPos;
-
-std::map<const char*, GLuint> textureLoaderMap;
+//Where the uniform blocks are bound
+const GLuint frameDataBinding = 0;
+const GLuint objectDataBinding = 1;
+const GLuint materialsBinding = 2;
+
+//How many objects (or spheres) each job works on, below this a loop just runs on the simulation thread
+const size_t objectsPerJob = 64;
+const size_t spheresPerJob = 256;
+
+//Objects that passed their update this frame, with their transforms and bounding spheres, so they can all be culled at once
+std::vector<DrawObject*> objCandidates;
+std::vector<unsigned int> objCandidateIndices;
+std::vector<glm::vec4> objSpheres;
+std::vector<unsigned char> objVisible;
+
+//Layout of the sort key, the pass is in the highest bits so every draw of one pass stays together
+const int sortPassShift = 62;
+const int sortTranslucentShift = 61;
+const int sortShaderShift = 57;
+const uint64_t sortDepthMax = (1 << 24) - 1;
 
 float objRot;
-float newTime = 0.f;
-float oldTIme = 0.f;
+//The length of a simulation step, objects use it to move at the same speed however fast the game is drawn
 float deltaTime = 0.f;
 
-const char* noteModelLocation = "Models\\newRedCube.obj";
-const char* noteTextureLocation = "Textures\\newRedNote.png";
-
 //The construction function for the DrawObject class
 DrawObject::DrawObject(const char* modelPath, const char* texturePath, bool bHasCollision, float inOpacity, float inAmbient, bool hasBloom,
 	glm::vec3 inPos, glm::vec3 inScale, glm::vec3 inRotation, glm::vec3 collisionBoxSize)
@@ -25,90 +45,83 @@ DrawObject::DrawObject(const char* modelPath, const char* texturePath, bool bHas
 	pos = inPos;
 	scale = inScale;
 	rotation = inRotation;
-	opacity = inOpacity;
-	ambient = inAmbient;
-	bloom = hasBloom;
+	material = ObjectManager::addMaterial(inOpacity, inAmbient, hasBloom, 1.f);
 	//set Default properties
 	objVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
 	objAcceleration = glm::vec3(0.0f, 0.0f, 0.0f);
 	objRotationalVelocity = glm::vec3(0.0f, 0.f, 0.f);
-	//If the texture is already loaded it doesn't need to be loaded again
-	//Texture loader map keeps track of the paths of textures that have been buffered into OpenGL
-	if (textureLoaderMap[texturePath] == 0) {
-		texture = ObjectLoader::loadTexture(texturePath);
-		textureLoaderMap[texturePath] = texture;
-	}
-	else {
-		texture = textureLoaderMap[texturePath];
-	}
-	//Loads the wavefront file with the obj loader and returns the details into these 3 array: vertexData, uvData, normalData
-	ObjectLoader::loadOBJ(modelPath, vertexData, uvData, normalData);
-	
-	//Buffers all the vertex and uv and normal data into their own buffers, these buffers store the data so it can be binded and then rendered
-	glGenVertexArrays(1, &VertexArrayID);
-	glBindVertexArray(VertexArrayID);
-
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(glm::vec3), &vertexData[0], GL_STATIC_DRAW);
+	//If the texture or model is already loaded it doesn't need to be loaded again, the AssetLoader keeps track of every file that has been requested
+	//If it hasn't been loaded it is loaded in the background, the object is only drawn once both have finished
+	texture = AssetLoader::requestTexture(texturePath);
+	mesh = AssetLoader::requestMesh(modelPath);
+}
 
-	glGenBuffers(1, &uvBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-	glBufferData(GL_ARRAY_BUFFER, uvData.size() * sizeof(glm::vec2), &uvData[0], GL_STATIC_DRAW);
+//The Default Draw Function
+//Nothing is drawn straight away, the ObjectManager sorts every draw first so objects sharing a texture or mesh are drawn together
+void DrawObject::Draw(const glm::mat4& modelview)
+{
+	//The distance from the camera is how far along the camera's view the object is (the view looks down -z)
+	float viewDepth = -modelview[3][2];
+
+	RenderCommand command;
+	command.key = ObjectManager::makeSortKey(ObjectManager::isTranslucent(material), texture->id, mesh->VertexArrayID, viewDepth);
+	command.texture = texture->id;
+	//The mesh's vertex array object already knows where the vertex, uv and normal buffers are, so binding it is all that's needed
+	command.VertexArrayID = mesh->VertexArrayID;
+	command.vertexCount = mesh->vertexCount;
+	command.instanceCount = 0;
+	command.firstInstance = 0;
+	command.mesh = mesh;
+	//The object's matrices and material go in the ObjectData uniform block
+	command.objectSlot = ObjectManager::pushObjectData(modelview, material);
+	ObjectManager::submit(command);
+}
 
-	glGenBuffers(1, &normalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, normalData.size() * sizeof(glm::vec3), &normalData[0], GL_STATIC_DRAW);
+//The sphere is moved with the object, and grows with the largest scale so it still covers the object when it's stretched
+glm::vec4 DrawObject::getBoundingSphere(const glm::mat4& transform)
+{
+	glm::vec4 center = transform * glm::vec4(mesh->boundsCenter, 1.f);
+	float largestScale = std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+	return glm::vec4(glm::vec3(center), mesh->boundsRadius * largestScale);
+}
 
-	objRenderQueue.push_back(this);
+bool DrawObject::isReady()
+{
+	return mesh != nullptr && texture != nullptr && mesh->loaded && texture->loaded;
 }
 
-//The Default Draw Function
-void DrawObject::Draw()
-{
-	//Update the fragment shader with these details
-	glUniform1f(opacityPos, opacity);
-	glUniform1f(ambientPos, ambient);
-	glUniform1i(bloomPos, bloom);
-	glUniform1f(brightnessPos, bloomAmmount);
-
-	//Binds the texture for the object into OpenGL so it can be used by the texture sampler in the fragment shader
-	glBindTexture(GL_TEXTURE_2D, texture);
-	//Load all the buffers into OpenGL so they can be used in the vertex and fragment shaders
-	glEnableVertexAttribArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glVertexAttribPointer(0,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		(void*)0
-	);
+void DrawObject::releaseAssets()
+{
+	AssetLoader::releaseMesh(mesh);
+	AssetLoader::releaseTexture(texture);
+	mesh = nullptr;
+	texture = nullptr;
+}
 
-	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-	glVertexAttribPointer(1,
-		2,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		(void*)0
-	);
+//Getters and setters for the transform, the setters flag which part of the matrix needs to be rebuilt
+const glm::vec3& DrawObject::getPosition() { return pos; }
+const glm::vec3& DrawObject::getRotation() { return rotation; }
+const glm::vec3& DrawObject::getScale() { return scale; }
+void DrawObject::setPosition(glm::vec3 newPosition) { pos = newPosition; }
+void DrawObject::setRotation(glm::vec3 newRotation) { rotation = newRotation; }
+//Scale isn't blended between steps, so changing it flags the matrix straight away
+void DrawObject::setScale(glm::vec3 newScale)
+{
+	if (newScale != scale) {
+		scale = newScale;
+		bBasisDirty = true;
+	}
+}
 
-	glEnableVertexAttribArray(2);
-	glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-	
-	glVertexAttribPointer(2,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		0,
-		(void*)0
-	);
-	//Draw the Object
-	glDrawArrays(GL_TRIANGLES, 0, vertexData.size());
+void DrawObject::storePreviousTransform()
+{
+	previousPos = pos;
+	previousRotation = rotation;
 }
 
+glm::vec3 DrawObject::getInterpolatedPosition(float alpha) { return previousPos + (pos - previousPos) * alpha; }
+glm::vec3 DrawObject::getInterpolatedRotation(float alpha) { return previousRotation + (rotation - previousRotation) * alpha; }
+
 //Default setter function for private variables
 void DrawObject::setRotationalVelocity(glm::vec3 newRotationalVelocity) { objRotationalVelocity = newRotationalVelocity; }
 void DrawObject::setNewVelocity(glm::vec3 newVelocity) { objVelocity = newVelocity; }
@@ -116,199 +129,538 @@ void DrawObject::setNewAcceleration(glm::vec3 newAcceleration) { objAcceleration
 
 //Default update function called every frame (Changes the rotation and velocity if the object has a constant acceleration or velocity)
 void DrawObject::Update() {
-	rotation += objRotationalVelocity * deltaTime;
+	setRotation(rotation + objRotationalVelocity * deltaTime);
 	
-	pos += objVelocity * deltaTime;
+	setPosition(pos + objVelocity * deltaTime);
 	objVelocity += objAcceleration * deltaTime;
 }
 
-//Adds DrawObject to the render queue
-void ObjectManager::addObjectToQueue(DrawObject* obj)
+//Class variables defined out of scope
+std::vector<ObjectManager::ObjectSlot> ObjectManager::slots;
+std::vector<unsigned int> ObjectManager::freeSlots;
+std::vector<DrawObject*> ObjectManager::liveObjects;
+std::vector<unsigned int> ObjectManager::liveSlots;
+std::vector<glm::mat4> ObjectManager::liveTransforms;
+std::vector<unsigned int> ObjectManager::dirtyTransforms;
+std::vector<ObjectHandle> ObjectManager::pendingDestroy;
+GLuint ObjectManager::frameBuffer = 0;
+GLuint ObjectManager::objectBuffer = 0;
+GLuint ObjectManager::materialBuffer = 0;
+GLint ObjectManager::objectStride = sizeof(ObjectData);
+std::vector<unsigned char> ObjectManager::objectStaging;
+unsigned int ObjectManager::uploadedMaterialsVersion = 0;
+std::vector<Material> ObjectManager::materials;
+unsigned int ObjectManager::materialsVersion = 1;
+RenderSnapshot* ObjectManager::building = nullptr;
+const float ObjectManager::maxSortDepth = 256.f;
+float ObjectManager::frustumPlanes[4][6];
+std::atomic<size_t> ObjectManager::culledCount(0);
+std::atomic<size_t> ObjectManager::drawnCount(0);
+
+//Puts the object in a free slot (or a new one if none are free) and on the end of the packed array
+ObjectHandle ObjectManager::addObject(DrawObject* obj, bool bOwned)
 {
-	objRenderQueue.push_back(obj);
+	unsigned int index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		index = (unsigned int)slots.size();
+		slots.push_back(ObjectSlot());
+	}
+	ObjectSlot& slot = slots[index];
+	slot.obj = obj;
+	slot.liveIndex = (unsigned int)liveObjects.size();
+	slot.bOwned = bOwned;
+	slot.bPendingDestroy = false;
+	liveObjects.push_back(obj);
+	liveSlots.push_back(index);
+	liveTransforms.push_back(glm::mat4(1.f));
+	//A new object hasn't moved yet, so it's drawn exactly where it starts
+	obj->storePreviousTransform();
+	obj->bPositionDirty = true;
+	obj->bBasisDirty = true;
+
+	obj->handle.index = index;
+	obj->handle.generation = slot.generation;
+	obj->bToDelete = false;
+	return obj->handle;
 }
 
-//Default renderQueue function called outside the class, updates the change in time 
-void ObjectManager::renderQueue() {
-	glUniform1i(bloomPos, false); //Bloom should be false by defauly
-	newTime = glutGet(GLUT_ELAPSED_TIME);
-	deltaTime = (newTime - oldTIme) / 1000.f;
-	oldTIme = newTime;
+bool ObjectManager::isValid(ObjectHandle handle)
+{
+	return handle.index < slots.size() && slots[handle.index].generation == handle.generation && slots[handle.index].obj != nullptr;
+}
 
-	objRot += 0.01f;
-	renderQueue(objRenderQueue);
+DrawObject* ObjectManager::getObject(ObjectHandle handle)
+{
+	return isValid(handle) ? slots[handle.index].obj : nullptr;
 }
 
-//Actually renders the renderQueue, called from the other function
-//This type of function has a parammeter overide (has the same name as another function, but different argument requirements)
-void ObjectManager::renderQueue(std::vector<DrawObject*> &rendQueue)
+void ObjectManager::destroyObject(ObjectHandle handle)
 {
-	//Iterate through all the objects in the render queue
-	for (int objIndex = 0; objIndex < rendQueue.size(); objIndex++) {
-		DrawObject* renderObj = rendQueue[objIndex];
-		//Update the object
-		renderObj->Update();
-		//Calculate the modelview
-		glm::mat4 translateMatrix = MatrixFunctions::translate(renderObj->pos);
-		glm::mat4 scaleMatrix = MatrixFunctions::scale(renderObj->scale);
+	if (!isValid(handle) || slots[handle.index].bPendingDestroy) {
+		return;
+	}
+	slots[handle.index].bPendingDestroy = true;
+	slots[handle.index].obj->bToDelete = true;
+	pendingDestroy.push_back(handle);
+}
 
-		glm::vec3 vec3rot = renderObj->rotation;
+size_t ObjectManager::objectCount()
+{
+	return liveObjects.size();
+}
 
-		glm::mat4 rotMatrix = MatrixFunctions::rotateZ(vec3rot.z) * MatrixFunctions::rotateY(vec3rot.y) * MatrixFunctions::rotateX(vec3rot.x);
+//Removes every object waiting to be destroyed
+//The last object in the packed array is moved into the gap (swap and pop), then the slot's generation is increased and the slot is reused later
+void ObjectManager::flushDestroyed()
+{
+	for (ObjectHandle handle : pendingDestroy) {
+		if (!isValid(handle)) {
+			continue;
+		}
+		ObjectSlot& slot = slots[handle.index];
+		unsigned int gap = slot.liveIndex;
+		unsigned int last = (unsigned int)liveObjects.size() - 1;
+		liveObjects[gap] = liveObjects[last];
+		liveSlots[gap] = liveSlots[last];
+		liveTransforms[gap] = liveTransforms[last];
+		slots[liveSlots[gap]].liveIndex = gap;
+		liveObjects.pop_back();
+		liveSlots.pop_back();
+		liveTransforms.pop_back();
+
+		//Objects the ObjectManager owns give their buffers back to the AssetLoader, which deletes them once nothing else uses them
+		if (slot.bOwned) {
+			slot.obj->releaseAssets();
+			delete slot.obj;
+		}
+		slot.obj = nullptr;
+		slot.bPendingDestroy = false;
+		slot.generation++;
+		freeSlots.push_back(handle.index);
+	}
+	pendingDestroy.clear();
+}
 
-		glm::mat4 transformMat = translateMatrix * rotMatrix * scaleMatrix;
-		//Update the vertex and fragment shader
-		glUniformMatrix4fv(objModelviewPos, 1, GL_FALSE, &(objModelview * transformMat)[0][0]);
-		//Call that object's draw function
-		renderObj->Draw();
+//Materials are looked up by value, so every object with the same look shares one entry
+int ObjectManager::addMaterial(float opacity, float ambient, bool bloom, float brightness)
+{
+	Material newMaterial = { opacity, ambient, brightness, bloom ? 1.f : 0.f };
+	for (size_t i = 0; i < materials.size(); i++) {
+		const Material& existing = materials[i];
+		if (existing.opacity == newMaterial.opacity && existing.ambient == newMaterial.ambient
+			&& existing.brightness == newMaterial.brightness && existing.bloom == newMaterial.bloom) {
+			return (int)i;
+		}
 	}
-	//Delete all objects flagged for deletion
-	for (int delCount = 0; delCount < rendQueue.size(); delCount++) {
-		if (rendQueue[delCount]->bToDelete) {
-			rendQueue.erase(rendQueue.begin() + delCount);
+	if (materials.size() >= (size_t)maxMaterials) {
+		std::cout << "Too many materials, using material 0" << std::endl;
+		return 0;
+	}
+	materials.push_back(newMaterial);
+	materialsVersion++;
+	return (int)materials.size() - 1;
+}
+
+void ObjectManager::beginFrame(RenderSnapshot& snapshot, const glm::mat4& projection, glm::vec3 lightPos)
+{
+	building = &snapshot;
+	snapshot.frame.projection = projection;
+	snapshot.frame.lightPos = glm::vec4(lightPos, 1.f);
+	snapshot.frame.viewPos = glm::inverse(objModelview)[3];
+	//There are never more than 64 materials, so they're copied into every snapshot, the render thread only uploads them when the version changes
+	snapshot.materials = materials;
+	snapshot.materialsVersion = materialsVersion;
+
+	//The planes of the view come straight out of the rows of projection * view (Gribb and Hartmann's method)
+	//Each plane is row 3 plus or minus one of the other rows, normalised so distances to it are in world units
+	glm::mat4 viewProjection = projection * objModelview;
+	for (int plane = 0; plane < 6; plane++) {
+		int row = plane / 2;
+		float sign = (plane % 2 == 0) ? 1.f : -1.f;
+		glm::vec4 equation;
+		for (int column = 0; column < 4; column++) {
+			equation[column] = viewProjection[column][3] + sign * viewProjection[column][row];
+		}
+		equation /= glm::length(glm::vec3(equation));
+		for (int component = 0; component < 4; component++) {
+			frustumPlanes[component][plane] = equation[component];
 		}
 	}
+	culledCount = 0;
+	drawnCount = 0;
 }
 
-void ObjectManager::Init(GLuint program)
+//A sphere can't be seen if it's entirely behind any one of the 6 planes (its distance to the plane is less than -radius)
+//4 spheres are loaded and turned sideways (so one register holds all 4 x values, one all 4 y values and so on), then each plane is tested against all 4 at once
+void ObjectManager::cullSpheres(const glm::vec4* spheres, size_t count, unsigned char* visible)
 {
-	//Retrieves the locations of uniform variables inside the shader
-	objModelviewPos = glGetUniformLocation(program, "modelview");
-	objModelview = glm::lookAt(glm::vec3(0, 0, 60.f), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-	glUniformMatrix4fv(objModelviewPos, 1, GL_FALSE, &(objModelview)[0][0]);
-
-	opacityPos = glGetUniformLocation(program, "opacity"); //How "see-through" should an object be
-	ambientPos = glGetUniformLocation(program, "ambient"); //Minimum brightness of an object
-	bloomPos = glGetUniformLocation(program, "bBloom"); //Should the object have bloom
-	brightnessPos = glGetUniformLocation(program, "brightness");
-}
-
-//Note Target Constructor Function
-NoteTarget::NoteTarget(float xPos, float noteKey, float noteTime, float noteLength, float noteVelocity, AudioManager* inAudioManager, PlayerController* playerObject)
-{
-	//DrawObject inherited properties defined for this class
-	hasCollision = true;
-	time = noteTime;
-	pos = glm::vec3(xPos, noteKey, (noteTime * -noteVelocity));
-	scale = glm::vec3(2.f, 2.f, 2.f);
-	rotation = glm::vec3(0.f, 0.f, 0.f);
-	bloom = true;
-	objAudioManager = inAudioManager;
-	currentPlayer = playerObject;
-	ambient = 0.4f;
-	bloomAmmount = 2.5f;
-	//How big object's collision should be
-	noteCollisionBox = CollisionBox(1.f, 1.f, 1.f);
-
-	velocity = noteVelocity;
-
-	//Same code to buffer vertex, normal and uv data as in the default constructor in the DrawObject class, does the same thing here
-	if (textureLoaderMap[noteTextureLocation] == 0) {
-		texture = ObjectLoader::loadTexture(noteTextureLocation);
+	size_t simdCount = count & ~(size_t)3;
+	for (size_t i = 0; i < simdCount; i += 4) {
+		__m128 x = _mm_loadu_ps(&spheres[i][0]);
+		__m128 y = _mm_loadu_ps(&spheres[i + 1][0]);
+		__m128 z = _mm_loadu_ps(&spheres[i + 2][0]);
+		__m128 radius = _mm_loadu_ps(&spheres[i + 3][0]);
+		_MM_TRANSPOSE4_PS(x, y, z, radius);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+		__m128 outside = _mm_setzero_ps();
+		for (int plane = 0; plane < 6; plane++) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(frustumPlanes[0][plane])), _mm_mul_ps(y, _mm_set1_ps(frustumPlanes[1][plane]))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(frustumPlanes[2][plane])), _mm_set1_ps(frustumPlanes[3][plane])));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+		}
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++) {
+			visible[i + lane] = !((outsideMask >> lane) & 1);
+		}
 	}
-	else {
-		texture = textureLoaderMap[noteTextureLocation];
+	//The spheres left over when the count isn't a multiple of 4
+	for (size_t i = simdCount; i < count; i++) {
+		bool bInside = true;
+		for (int plane = 0; plane < 6 && bInside; plane++) {
+			float distance = spheres[i].x * frustumPlanes[0][plane] + spheres[i].y * frustumPlanes[1][plane]
+				+ spheres[i].z * frustumPlanes[2][plane] + frustumPlanes[3][plane];
+			bInside = distance >= -spheres[i].w;
+		}
+		visible[i] = bInside;
 	}
-	ObjectLoader::loadOBJ(noteModelLocation, vertexData, uvData, normalData);
-
-	glGenVertexArrays(1, &VertexArrayID);
-	glBindVertexArray(VertexArrayID);
+}
 
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(glm::vec3), &vertexData[0], GL_STATIC_DRAW);
+void ObjectManager::countCulled(size_t culled, size_t drawn)
+{
+	culledCount += culled;
+	drawnCount += drawn;
+}
 
-	glGenBuffers(1, &uvBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-	glBufferData(GL_ARRAY_BUFFER, uvData.size() * sizeof(glm::vec2), &uvData[0], GL_STATIC_DRAW);
+size_t ObjectManager::getCulledCount()
+{
+	return culledCount;
+}
 
-	glGenBuffers(1, &normalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, normalData.size() * sizeof(glm::vec3), &normalData[0], GL_STATIC_DRAW);
+size_t ObjectManager::getDrawnCount()
+{
+	return drawnCount;
+}
 
-	//Calls for the creation of a NoteHighlight, a note highlight outlines on the screen where a note is going to be
-	DrawObject* noteHighlight = new NoteHighlight(noteTime, this, inAudioManager);
-	objRenderQueue.push_back(this);
+//The normal matrix only depends on the object, so it's worked out here once instead of for every vertex in the shader
+unsigned int ObjectManager::pushObjectData(const glm::mat4& modelview, int material, const glm::mat4* instanceBase)
+{
+	ObjectData data;
+	data.modelview = modelview;
+	data.instanceBase = instanceBase ? *instanceBase : glm::mat4(1.f);
+	//Instances are only moved, and moving doesn't change which way a normal faces, so every instance can share the same normal matrix
+	data.normalMatrix = glm::transpose(glm::inverse(modelview * data.instanceBase));
+	data.material = material;
+	data.bInstanced = instanceBase != nullptr;
+	data.padding[0] = data.padding[1] = 0;
+
+	building->objects.push_back(data);
+	return (unsigned int)building->objects.size() - 1;
 }
 
-//Updates the note to move closer to the player as the song progresses
-void NoteTarget::Update()
+unsigned int ObjectManager::pushInstances(const glm::vec4* instances, size_t count)
 {
-	//Calculate how close the note should be based on the play position of the song
-	float playPos = objAudioManager->getPlayPos();
-	float dist = time - playPos;
+	unsigned int first = (unsigned int)building->instances.size();
+	building->instances.insert(building->instances.end(), instances, instances + count);
+	return first;
+}
 
-	glm::vec3 planePos = glm::vec3(currentPlayer->posX, currentPlayer->posY, 0);
-	//Is the player object is colliding with the player, the score should be incremented and the note should be deleted
-	if (CollisionBox::checkCollision(pos, colBox, planePos, currentPlayer->playerCollision)) {
-		if (!bToDelete) {
-			currentPlayer->playerScore += 100; //Increase score by 100
-			*currentPlayer->playerScoreText = std::to_string(currentPlayer->playerScore);
-		}
-		bToDelete = true;
+//Every object's data is sent in one upload, giving the buffer new memory so the last frame's draws don't have to finish first
+//The snapshot keeps the objects packed together, they're spaced out to the buffer's alignment here
+void ObjectManager::uploadObjectData(const RenderSnapshot& snapshot)
+{
+	size_t objectCount = snapshot.objects.size();
+	if (objectStaging.size() < objectCount * objectStride) {
+		objectStaging.resize(objectCount * objectStride);
 	}
-	pos.z = (dist * -velocity) - scale.z;
-	//If the note object is too far past the player it should be deleted
-	if (pos.z > 40.f) {
-		pos.z = 40.f;
-		bToDelete = true;
+	for (size_t i = 0; i < objectCount; i++) {
+		memcpy(&objectStaging[i * objectStride], &snapshot.objects[i], sizeof(ObjectData));
 	}
+	glBindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, objectCount * objectStride, objectCount > 0 ? objectStaging.data() : nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
+void ObjectManager::bindObjectData(unsigned int slot)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, objectDataBinding, objectBuffer, (GLintptr)slot * objectStride, sizeof(ObjectData));
 }
 
-//Constructor for the note highlight
-NoteHighlight::NoteHighlight(float inNoteTime, DrawObject* inParentNote, AudioManager* audioIn)
+bool ObjectManager::isTranslucent(int material)
 {
-	hasCollision = false;
-	DrawObject* parentNote = inParentNote;
-	pos = glm::vec3(parentNote->pos.x, parentNote->pos.y, 0.f);
-	scale = glm::vec3(2.f, 2.f, 2.f);
-	//Reset this line later after updating rotation
-	//rotation = glm::quat(glm::vec3(0.f, 0.f, 0.f));
-	rotation = glm::vec3(0.f, 1.570796327f, 0.f);
-	audioManager = audioIn;
-	highlightTime = 1.f;
-	ambient = 1.f;
-	noteTime = inNoteTime;
+	return material >= 0 && material < (int)materials.size() && materials[material].opacity < 1.f;
+}
 
-	texture = ObjectLoader::loadTexture("Textures\\green.png");
-	ObjectLoader::loadOBJ("Models\\noteOutline.obj", vertexData, uvData, normalData);
-	//Same code for buffering in the vertex, uv and normal data as the DrawObject class
-	glGenVertexArrays(1, &VertexArrayID);
-	glBindVertexArray(VertexArrayID);
+uint64_t ObjectManager::makeSortKey(bool bTranslucent, GLuint texture, GLuint VertexArrayID, float viewDepth)
+{
+	//Only the phong shader draws the scene, so the pass and shader are always 0 for now
+	const uint64_t pass = 0, shader = 0;
+	float depthFraction = std::min(std::max(viewDepth / maxSortDepth, 0.f), 1.f);
+	uint64_t depth = (uint64_t)(depthFraction * sortDepthMax);
+	uint64_t textureBits = texture & 0xFFFF;
+	uint64_t meshBits = VertexArrayID & 0xFFFF;
+
+	uint64_t key = (pass << sortPassShift) | ((uint64_t)bTranslucent << sortTranslucentShift) | (shader << sortShaderShift);
+	if (bTranslucent) {
+		//Furthest first, so the depth is flipped
+		key |= ((sortDepthMax - depth) << 33) | (textureBits << 17) | (meshBits << 1);
+	}
+	else {
+		key |= (textureBits << 41) | (meshBits << 25) | (depth << 1);
+	}
+	return key;
+}
 
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(glm::vec3), &vertexData[0], GL_STATIC_DRAW);
+void ObjectManager::submit(const RenderCommand& command)
+{
+	building->commands.push_back(command);
+}
 
-	glGenBuffers(1, &uvBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-	glBufferData(GL_ARRAY_BUFFER, uvData.size() * sizeof(glm::vec2), &uvData[0], GL_STATIC_DRAW);
+//The mesh's own buffers plus its instance buffer (attribute 3, advanced once per instance)
+GLuint ObjectManager::getInstancedVertexArray(MeshAsset* mesh)
+{
+	if (mesh->instancedVertexArrayID == 0) {
+		glGenVertexArrays(1, &mesh->instancedVertexArrayID);
+		glBindVertexArray(mesh->instancedVertexArrayID);
+
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->uvBuffer);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->normalBuffer);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+		//The instances are in the stream buffer at a different place every draw, so attribute 3 is pointed at them when drawing (see executeCommands)
+		glEnableVertexAttribArray(3);
+		glVertexAttribDivisor(3, 1);
+		glBindVertexArray(0);
+	}
+	return mesh->instancedVertexArrayID;
+}
 
-	glGenBuffers(1, &normalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, normalData.size() * sizeof(glm::vec3), &normalData[0], GL_STATIC_DRAW);
+//Uploads the frame's data, then draws its commands
+void ObjectManager::drawSnapshot(const RenderSnapshot& snapshot, StreamBuffer& stream)
+{
+	if (frameBuffer == 0) {
+		return;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &snapshot.frame);
+
+	//Materials rarely change, so they're only uploaded when one has been added
+	if (snapshot.materialsVersion != uploadedMaterialsVersion) {
+		glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, snapshot.materials.size() * sizeof(Material), snapshot.materials.data());
+		uploadedMaterialsVersion = snapshot.materialsVersion;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	uploadObjectData(snapshot);
+	//Every instanced draw's instances are written in one go, each draw then reads its own range of them
+	GLintptr instancesOffset = -1;
+	if (!snapshot.instances.empty()) {
+		instancesOffset = stream.write(snapshot.instances.data(), snapshot.instances.size() * sizeof(glm::vec4), sizeof(glm::vec4));
+	}
+	executeCommands(snapshot, stream.getBuffer(), instancesOffset);
+}
 
-	objRenderQueue.push_back(this);
+//Draws every command in key order
+//Commands next to each other usually share a texture or mesh, so a bind is only made when it's different to the last one
+//Blending is only needed for translucent draws, which all come after the opaque ones
+void ObjectManager::executeCommands(const RenderSnapshot& snapshot, GLuint instanceBuffer, GLintptr instancesOffset)
+{
+	const GLuint unbound = 0xFFFFFFFF;
+	GLuint boundTexture = unbound, boundVertexArray = unbound;
+	glDisable(GL_BLEND);
+	bool bBlending = false;
+	for (const RenderCommand& command : snapshot.commands) {
+		bool bTranslucent = (command.key >> sortTranslucentShift) & 1;
+		if (bTranslucent && !bBlending) {
+			glEnable(GL_BLEND);
+			bBlending = true;
+		}
+		bindObjectData(command.objectSlot);
+		if (command.texture != boundTexture) {
+			glBindTexture(GL_TEXTURE_2D, command.texture);
+			boundTexture = command.texture;
+		}
+		if (command.instanceCount > 0) {
+			if (instancesOffset < 0) {
+				continue;
+			}
+			glBindVertexArray(getInstancedVertexArray(command.mesh));
+			boundVertexArray = unbound;
+			glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+			glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 0, (void*)(instancesOffset + command.firstInstance * sizeof(glm::vec4)));
+			glDrawArraysInstanced(GL_TRIANGLES, 0, command.vertexCount, command.instanceCount);
+			continue;
+		}
+		if (command.VertexArrayID != boundVertexArray) {
+			glBindVertexArray(command.VertexArrayID);
+			boundVertexArray = command.VertexArrayID;
+		}
+		glDrawArrays(GL_TRIANGLES, 0, command.vertexCount);
+	}
+	//The GUI is drawn afterwards and expects blending to be on
+	glEnable(GL_BLEND);
+	glBindVertexArray(0);
+}
 
+//The changed matrices are all in one contiguous array, an object that has only moved just has its translation replaced
+//Every object has its own matrix, so the dirty list is split between jobs
+void ObjectManager::updateTransforms()
+{
+	JobSystem::parallelFor(dirtyTransforms.size(), objectsPerJob, [](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			unsigned int objIndex = dirtyTransforms[i];
+			DrawObject* obj = liveObjects[objIndex];
+			if (obj->bBasisDirty) {
+				MatrixFunctions::composeTRS(obj->renderPos, obj->renderRotation, obj->getScale(), liveTransforms[objIndex]);
+			}
+			else {
+				MatrixFunctions::setTranslation(obj->renderPos, liveTransforms[objIndex]);
+			}
+			obj->bPositionDirty = false;
+			obj->bBasisDirty = false;
+		}
+	});
 }
 
-//Updates similarly to the noteObject update function, based on time
-void NoteHighlight::Update()
+//One simulation step, every object's Update is run with deltaTime set to the fixed step length
+//Destroying an object changes the ObjectManager's lists, so that's done first on this thread, then the updates are split between jobs
+void ObjectManager::simulate(float step)
 {
-	float playPos = audioManager->getPlayPos();
-	float difTime = (highlightTime - (noteTime - playPos)) / highlightTime;
-	//Opacity increases as the NoteObject gets closer to the player
-	opacity = std::min(std::max(difTime, 0.f), 1.f);
-	//Should be deleted after the point when the note should've been hit
-	if (playPos > noteTime) {
-		bToDelete = true;
+	deltaTime = step;
+	for (size_t objIndex = 0; objIndex < liveObjects.size(); objIndex++) {
+		DrawObject* obj = liveObjects[objIndex];
+		//Objects can flag themselves for deletion by setting bToDelete
+		if (obj->bToDelete) {
+			destroyObject(obj->handle);
+		}
+	}
+	JobSystem::parallelFor(liveObjects.size(), objectsPerJob, [](size_t begin, size_t end) {
+		for (size_t objIndex = begin; objIndex < end; objIndex++) {
+			DrawObject* obj = liveObjects[objIndex];
+			if (obj->bToDelete) {
+				continue;
+			}
+			obj->storePreviousTransform();
+			//Update the object
+			obj->Update();
+		}
+	});
+}
+
+//Default renderQueue function called outside the class
+//The notes don't depend on any object, so they're moved and culled by a job while the objects are prepared here
+void ObjectManager::renderQueue(float alpha) {
+	PROFILE_ZONE("ObjectManager::renderQueue");
+	objRot += 0.01f;
+	JobCounter notesPrepared;
+	JobSystem::run([alpha]() { NoteField::prepareDraw(alpha); }, notesPrepared);
+
+	//Works out where every object is drawn this frame, keeping track of the ones whose matrix needs to change
+	dirtyTransforms.clear();
+	for (size_t objIndex = 0; objIndex < liveObjects.size(); objIndex++) {
+		DrawObject* obj = liveObjects[objIndex];
+		glm::vec3 framePos = obj->getInterpolatedPosition(alpha);
+		glm::vec3 frameRotation = obj->getInterpolatedRotation(alpha);
+		if (framePos != obj->renderPos) {
+			obj->renderPos = framePos;
+			obj->bPositionDirty = true;
+		}
+		if (frameRotation != obj->renderRotation) {
+			obj->renderRotation = frameRotation;
+			obj->bBasisDirty = true;
+		}
+		if (obj->bPositionDirty || obj->bBasisDirty) {
+			dirtyTransforms.push_back((unsigned int)objIndex);
+		}
+	}
+	//Static objects (like the night sky) keep the matrix they had last frame
+	updateTransforms();
+
+	//Every draw is collected first so the draws can be culled, sorted and their data uploaded at once
+	objCandidateIndices.clear();
+	objSpheres.clear();
+	for (size_t objIndex = 0; objIndex < liveObjects.size(); objIndex++) {
+		DrawObject* renderObj = liveObjects[objIndex];
+		//Objects whose model or texture are still loading are skipped until they are ready
+		if (renderObj->bToDelete || !renderObj->isReady()) {
+			continue;
+		}
+		objCandidateIndices.push_back((unsigned int)objIndex);
 	}
+	objSpheres.resize(objCandidateIndices.size());
+	JobSystem::parallelFor(objCandidateIndices.size(), objectsPerJob, [](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			unsigned int objIndex = objCandidateIndices[i];
+			objSpheres[i] = liveObjects[objIndex]->getBoundingSphere(liveTransforms[objIndex]);
+		}
+	});
+	//Only objects that can be seen are drawn
+	objVisible.resize(objCandidateIndices.size());
+	JobSystem::parallelFor(objSpheres.size(), spheresPerJob, [](size_t begin, size_t end) {
+		cullSpheres(objSpheres.data() + begin, end - begin, objVisible.data() + begin);
+	});
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < objCandidateIndices.size(); i++) {
+		if (objVisible[i]) {
+			unsigned int objIndex = objCandidateIndices[i];
+			//Call that object's draw function
+			liveObjects[objIndex]->Draw(MatrixFunctions::multiply(objModelview, liveTransforms[objIndex]));
+			visibleCount++;
+		}
+	}
+	countCulled(objCandidateIndices.size() - visibleCount, visibleCount);
+	//Every note is drawn by the NoteField in two instanced draw calls
+	JobSystem::wait(notesPrepared);
+	NoteField::Draw(objModelview);
+	//Sorted here so the render thread only has to draw them
+	std::sort(building->commands.begin(), building->commands.end(), [](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+	building = nullptr;
+
+	//Delete all objects flagged for deletion
+	flushDestroyed();
 }
 
-const char* filePath = "Models\\plane.obj";
-const char* texturePath;
-GLuint planeOpacityPos, planeAmbientPos;
+void ObjectManager::Init(GLuint program)
+{
+	//Tells the shader which binding each uniform block reads from
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "FrameData"), frameDataBinding);
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "ObjectData"), objectDataBinding);
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Materials"), materialsBinding);
+	//Called again when the program is reloaded, the buffers are kept
+	if (frameBuffer != 0) {
+		return;
+	}
+
+	//Each object's slot has to start on a multiple of the uniform buffer alignment
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	objectStride = ((GLint)sizeof(ObjectData) + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &frameBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, frameDataBinding, frameBuffer);
+
+	glGenBuffers(1, &materialBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, maxMaterials * sizeof(Material), nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, materialsBinding, materialBuffer);
+	uploadedMaterialsVersion = 0;
+
+	glGenBuffers(1, &objectBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
 //Default Player Constructor Function
 PlayerController::PlayerController()
@@ -325,41 +677,21 @@ PlayerController::PlayerController()
 
 //DrawObject position is updated to reflect the stored position inside the class
 void PlayerController::Update() {
-	pos = glm::vec3(posX, posY, 0.f);
+	setPosition(glm::vec3(posX, posY, 0.f));
 }
 
 //Setup function needed because some OpenGL calls can't be made until glut has been initialised and the program shaders have been compiled
-void PlayerController::Setup(const char* tPath, GLuint planeShaderProgram)
+void PlayerController::Setup(const char* tPath)
 {
 	scale = glm::vec3(1.f, 1.f, 1.f);
-	opacity = 1.f;
-	ambient = 0.7f;
-
-	texturePath = tPath;
-
-	planeOpacityPos = glGetUniformLocation(planeShaderProgram, "opacity");
-	planeAmbientPos = glGetUniformLocation(planeShaderProgram, "ambient");
+	material = ObjectManager::addMaterial(1.f, 0.7f, false, 1.f);
 
 	playerCollision = CollisionBox(3.f, 1.5f, 6.0f);
-	//Loads in vertex, normal and uv data; same as the default draw object function
-	ObjectLoader::loadOBJ("Models\\planeUV2.obj", vertexData, uvData, normalData);
-	glGenVertexArrays(1, &VertexArrayID);
-	glBindVertexArray(VertexArrayID);
-
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(glm::vec3), &vertexData[0], GL_STATIC_DRAW);
-
-	glGenBuffers(1, &uvBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-	glBufferData(GL_ARRAY_BUFFER, uvData.size() * sizeof(glm::vec2), &uvData[0], GL_STATIC_DRAW);
-
-	glGenBuffers(1, &normalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, normalData.size() * sizeof(glm::vec3), &normalData[0], GL_STATIC_DRAW);
-
-	texture = ObjectLoader::loadTexture(tPath);
-	ObjectManager::addObjectToQueue(this);
+	//Requests the model and texture from the AssetLoader; same as the default draw object function
+	mesh = AssetLoader::requestMesh("Models\\planeUV2.obj");
+	texture = AssetLoader::requestTexture(tPath);
+	//The player isn't created with new, so the ObjectManager mustn't delete it
+	ObjectManager::addObject(this, false);
 }
 
 //Function is called every frame
@@ -409,6 +741,34 @@ bool CollisionBox::checkCollision(glm::vec3 pos1, CollisionBox box1, glm::vec3 p
 	return collisionX && collisionY && collisionZ;
 }
 
+//Continuous version of checkCollision, so fast objects can't pass straight through each other between two frames
+//Box 2 is treated as moving relative to box 1, and the boxes overlap when the distance between them is within both their sizes added together
+//For each axis this gives the fraction of the movement (between 0 and 1) where they overlap on that axis, they collide if all 3 ranges share a point
+bool CollisionBox::sweptCollision(glm::vec3 start1, glm::vec3 end1, CollisionBox box1, glm::vec3 start2, glm::vec3 end2, CollisionBox box2) {
+	glm::vec3 offset = start2 - start1;
+	glm::vec3 movement = (end2 - start2) - (end1 - start1);
+	glm::vec3 reach = glm::vec3(box1.x + box2.x, box1.y + box2.y, box1.z + box2.z);
+
+	float enter = 0.f, exit = 1.f;
+	for (int axis = 0; axis < 3; axis++) {
+		if (movement[axis] == 0.f) {
+			//Not moving on this axis, so they either always or never overlap on it
+			if (std::abs(offset[axis]) > reach[axis]) {
+				return false;
+			}
+			continue;
+		}
+		float t1 = (-reach[axis] - offset[axis]) / movement[axis];
+		float t2 = (reach[axis] - offset[axis]) / movement[axis];
+		enter = std::max(enter, std::min(t1, t2));
+		exit = std::min(exit, std::max(t1, t2));
+		if (enter > exit) {
+			return false;
+		}
+	}
+	return true;
+}
+
 //Matrix Functions
 glm::mat4 MatrixFunctions::translate(glm::vec3 position) {
 	glm::mat4 transMat =  glm::mat4(
@@ -495,3 +855,43 @@ glm::mat4 MatrixFunctions::rotateZ(float angle)
 	);
 	return glm::transpose(rot);
 }
+
+//glm stores matrices column by column, so each column of the result is written directly
+//With R = rotateZ * rotateY * rotateX multiplied out by hand, column j of the matrix is column j of R times scale[j], and the last column is the position
+//Only 3 sin/cos pairs are needed, and the scaling is done on whole columns with SSE
+void MatrixFunctions::composeTRS(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::mat4& out)
+{
+	float sx = sin(rotation.x), cx = cos(rotation.x);
+	float sy = sin(rotation.y), cy = cos(rotation.y);
+	float sz = sin(rotation.z), cz = cos(rotation.z);
+
+	__m128 column0 = _mm_setr_ps(cz * cy, -sz * cy, -sy, 0.f);
+	__m128 column1 = _mm_setr_ps(sz * cx - cz * sy * sx, cz * cx + sz * sy * sx, -cy * sx, 0.f);
+	__m128 column2 = _mm_setr_ps(sz * sx + cz * sy * cx, cz * sx - sz * sy * cx, cy * cx, 0.f);
+	_mm_storeu_ps(&out[0][0], _mm_mul_ps(column0, _mm_set1_ps(scale.x)));
+	_mm_storeu_ps(&out[1][0], _mm_mul_ps(column1, _mm_set1_ps(scale.y)));
+	_mm_storeu_ps(&out[2][0], _mm_mul_ps(column2, _mm_set1_ps(scale.z)));
+	setTranslation(position, out);
+}
+
+void MatrixFunctions::setTranslation(glm::vec3 position, glm::mat4& out)
+{
+	_mm_storeu_ps(&out[3][0], _mm_setr_ps(position.x, position.y, position.z, 1.f));
+}
+
+//Each column of a * b is a's columns added together, weighted by the values in the same column of b
+glm::mat4 MatrixFunctions::multiply(const glm::mat4& a, const glm::mat4& b)
+{
+	__m128 a0 = _mm_loadu_ps(&a[0][0]);
+	__m128 a1 = _mm_loadu_ps(&a[1][0]);
+	__m128 a2 = _mm_loadu_ps(&a[2][0]);
+	__m128 a3 = _mm_loadu_ps(&a[3][0]);
+	glm::mat4 result;
+	for (int column = 0; column < 4; column++) {
+		__m128 sum = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b[column][0])), _mm_mul_ps(a1, _mm_set1_ps(b[column][1]))),
+			_mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b[column][2])), _mm_mul_ps(a3, _mm_set1_ps(b[column][3]))));
+		_mm_storeu_ps(&result[column][0], sum);
+	}
+	return result;
+}
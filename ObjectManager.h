@@ -1,5 +1,8 @@
 #include "ObjectLoader.h"
 #include "AudioManager.h"
+#include "AssetLoader.h"
+#include "JobSystem.h"
+#include "StreamBuffer.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -8,6 +11,8 @@
 #include <GL/glew.h>
 #include <GL/glut.h>
 #include <vector>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <iostream>
 
@@ -18,6 +23,8 @@ private:
 public:
 	float x, y, z;
 	static bool checkCollision(glm::vec3 pos1, CollisionBox box1, glm::vec3 pos2, CollisionBox box2);
+	//Checks if two moving boxes touched at any point while moving from their start to their end positions
+	static bool sweptCollision(glm::vec3 start1, glm::vec3 end1, CollisionBox box1, glm::vec3 start2, glm::vec3 end2, CollisionBox box2);
 
 	CollisionBox(float inputX, float inputY, float inputZ);
 	CollisionBox();
@@ -29,6 +36,52 @@ public:
 	std::vector<glm::vec3> boxVertNorm;
 };
 
+//A reference to an object in the ObjectManager
+//Each slot's generation goes up when its object is destroyed, so an old handle can't be used to reach whatever object reuses the slot
+struct ObjectHandle {
+	unsigned int index = 0;
+	unsigned int generation = 0;
+};
+
+//How an object is shaded, shared by every object that looks the same and referred to by its index
+//Laid out the same as one vec4 in the Materials uniform block
+struct Material {
+	float opacity; //How "see-through" the object is
+	float ambient; //Minimum brightness of the object
+	float brightness; //How bright the object's bloom is
+	float bloom; //1 if the object has bloom, 0 if it doesn't
+};
+
+//Per object data sent to the Phong shader, laid out the same as the ObjectData uniform block (std140)
+struct ObjectData {
+	glm::mat4 modelview;
+	glm::mat4 normalMatrix;
+	glm::mat4 instanceBase;
+	int material;
+	int bInstanced;
+	int padding[2];
+};
+
+//Per frame data sent to the Phong shader, laid out the same as the FrameData uniform block (std140)
+struct FrameData {
+	glm::mat4 projection;
+	glm::vec4 lightPos;
+	glm::vec4 viewPos;
+};
+
+//One draw in the scene, every draw is collected into a list and sorted by its key before anything is drawn
+struct RenderCommand {
+	uint64_t key;
+	GLuint texture, VertexArrayID;
+	GLsizei vertexCount;
+	GLsizei instanceCount; //0 for a normal draw
+	unsigned int firstInstance; //Where the draw's instances start in the snapshot's instance list
+	MeshAsset* mesh; //Instanced draws use the mesh's instanced vertex array instead of VertexArrayID
+	unsigned int objectSlot; //Where the draw's data is in this frame's object buffer
+};
+
+struct RenderSnapshot;
+
 //Class containing the base class DrawObject
 class DrawObject {
 private:
@@ -37,27 +90,52 @@ private:
 	glm::vec3 objRotationalVelocity;
 protected:
 	//Information needed for rendering the geometry of a Rendered Object, it's texture data, and geometry data
-	GLuint texture;
-	std::vector<glm::vec3> vertexData, normalData;
-	std::vector<glm::vec2> uvData;
-	GLuint vertexBuffer, uvBuffer, VertexArrayID, normalBuffer;
-	//Default values for the fragment shader
-	float opacity = 1.f;
-	float ambient = 0.0f;
-	bool bloom = false;
-	float bloomAmmount = 1.f;
+	//Both are shared with every other object using the same files, and are loaded in the background by the AssetLoader
+	MeshAsset* mesh = nullptr;
+	TextureAsset* texture = nullptr;
+	//Index of the object's material in the ObjectManager
+	int material = 0;
+	//Where the object is, how it's rotated (in radians around x, y and z) and how it's scaled, as of the last simulation step
+	glm::vec3 pos = glm::vec3(0.f), scale = glm::vec3(1.f);
+	glm::vec3 rotation = glm::vec3(0.f);
+	//Where the object was the step before, frames are drawn part way between the two
+	glm::vec3 previousPos = glm::vec3(0.f), previousRotation = glm::vec3(0.f);
 public:
-	glm::vec3 pos, scale;
-	glm::vec3 rotation;
+	const glm::vec3& getPosition();
+	const glm::vec3& getRotation();
+	const glm::vec3& getScale();
+	void setPosition(glm::vec3 newPosition);
+	void setRotation(glm::vec3 newRotation);
+	void setScale(glm::vec3 newScale);
+	//Called at the start of every simulation step, before Update
+	void storePreviousTransform();
+	//Blends between the previous and current step, alpha is how far between them the frame is (0 to 1)
+	glm::vec3 getInterpolatedPosition(float alpha);
+	glm::vec3 getInterpolatedRotation(float alpha);
+
+	//The position and rotation the object's matrix was last built from
+	glm::vec3 renderPos = glm::vec3(0.f), renderRotation = glm::vec3(0.f);
+	//Which parts of the matrix need to be rebuilt
+	//Moving an object only changes the last column of its matrix, so it doesn't need the sin and cos work a rotation or scale change does
+	bool bPositionDirty = true, bBasisDirty = true;
 	//Constructor Function
 	DrawObject(const char* modelPath, const char* texturePath, bool bHasCollision, float inOpacity, float inAmbient, bool hasBloom,
 		glm::vec3 inPos, glm::vec3 inScale, glm::vec3 inRotation, glm::vec3 collisionBoxSize);
 	//Constructor should have default implementation
 	DrawObject() = default;
-	//Overridable draw function
-	virtual void Draw();
+	virtual ~DrawObject() = default;
+	//Overridable draw function, adds the object's draw to this frame's command list
+	virtual void Draw(const glm::mat4& modelview);
+	//The object's bounding sphere in world space (xyz centre, w radius), objects outside the view aren't drawn
+	glm::vec4 getBoundingSphere(const glm::mat4& transform);
+	//False until the object's mesh and texture have finished loading, objects aren't drawn until they are ready
+	bool isReady();
+	//Gives the mesh and texture back to the AssetLoader, called by the ObjectManager before it deletes the object
+	void releaseAssets();
 	//set To true when the object should be deleted
 	bool bToDelete = false;
+	//Where the object is in the ObjectManager, set when it's added
+	ObjectHandle handle;
 	CollisionBox noteCollisionBox;
 	bool hasCollision;
 
@@ -66,19 +144,116 @@ public:
 	void setNewVelocity(glm::vec3 newVelocity);
 	void setNewAcceleration(glm::vec3 newAcceleration);
 
+	//Objects are updated in parallel, so an Update should only change its own object
 	virtual void Update();
 };
 
 #pragma once
 //Object Manager Class
+//Every object in the scene is kept in a pool of slots, each slot is found through an ObjectHandle
+//The objects themselves are also kept in a packed array for drawing; removing one moves the last object into its place, so adding and removing both take the same time however many objects there are
+//Frames are built on the simulation thread into a RenderSnapshot (beginFrame and renderQueue), then drawn from the snapshot on the render thread (Init and drawSnapshot)
 class ObjectManager
 {
 public:
-	//Add objects to the GUIManager Queue
-	static void addObjectToQueue(DrawObject* obj);
-	static void renderQueue();
-	static void renderQueue(std::vector<DrawObject*> &rendQueue);
+	//Adds an object to the scene, if bOwned is true the ObjectManager deletes the object when it's destroyed
+	static ObjectHandle addObject(DrawObject* obj, bool bOwned = true);
+	//Returns nullptr if the object has been destroyed
+	static DrawObject* getObject(ObjectHandle handle);
+	//Objects aren't removed straight away, they're removed at the end of the next renderQueue so nothing is deleted while the scene is being drawn
+	static void destroyObject(ObjectHandle handle);
+	static size_t objectCount();
+	//Runs one fixed simulation step (step seconds long) on every object, the objects are split between the JobSystem's threads
+	static void simulate(float step);
+	//Adds a draw for every object to the snapshot started by beginFrame, alpha is how far the frame is between the last two simulation steps
+	static void renderQueue(float alpha);
+	//Called on the render thread once the phong program has been made (and again whenever it's reloaded)
 	static void Init(GLuint program);
+	//Uploads a snapshot's data and draws its commands, called on the render thread
+	//The instances for instanced draws are written into stream, which has to have had beginFrame called this frame
+	static void drawSnapshot(const RenderSnapshot& snapshot, StreamBuffer& stream);
+
+	//Returns the index of a material with these values, materials are shared so the same values always give the same index
+	static int addMaterial(float opacity, float ambient, bool bloom, float brightness);
+	//Starts building a frame into snapshot, with the data that is the same for every object this frame
+	static void beginFrame(RenderSnapshot& snapshot, const glm::mat4& projection, glm::vec3 lightPos);
+	//Adds an object's data to this frame's object buffer and returns its slot, the normal matrix is worked out here once per object
+	//instanceBase is only given for instanced draws
+	static unsigned int pushObjectData(const glm::mat4& modelview, int material, const glm::mat4* instanceBase = nullptr);
+	//Copies a draw's instances into the snapshot and returns where they start
+	static unsigned int pushInstances(const glm::vec4* instances, size_t count);
+
+	//Builds the key a draw is sorted by (highest bits first): pass, translucent, shader, then
+	//opaque draws: texture, mesh, depth (front to back, so the depth test can skip hidden pixels early)
+	//translucent draws: depth (back to front, so they blend correctly), texture, mesh
+	static uint64_t makeSortKey(bool bTranslucent, GLuint texture, GLuint VertexArrayID, float viewDepth);
+	//Adds a draw to this frame's command list
+	static void submit(const RenderCommand& command);
+	static bool isTranslucent(int material);
+
+	//Depths are spread over this distance when building sort keys
+	const static float maxSortDepth;
+
+	//Checks spheres (xyz centre, w radius) against the camera's view, 4 at a time with SSE
+	//visible[i] is set to 1 if sphere i can be seen, it's safe to call from several jobs at once
+	static void cullSpheres(const glm::vec4* spheres, size_t count, unsigned char* visible);
+	//Adds to this frame's counts of objects (or instances) that were culled and drawn, can be called from any job
+	static void countCulled(size_t culled, size_t drawn);
+	static size_t getCulledCount();
+	static size_t getDrawnCount();
+
+	const static int maxMaterials = 64;
+
+private:
+	struct ObjectSlot {
+		DrawObject* obj = nullptr;
+		unsigned int generation = 0;
+		unsigned int liveIndex = 0; //Where the object is in liveObjects
+		bool bOwned = false;
+		bool bPendingDestroy = false;
+	};
+	static bool isValid(ObjectHandle handle);
+	static void flushDestroyed();
+	//Rebuilds the matrices of every object whose transform has changed
+	static void updateTransforms();
+	//The snapshot being built, only set between beginFrame and the end of renderQueue
+	static RenderSnapshot* building;
+
+	//Render thread only
+	static void uploadObjectData(const RenderSnapshot& snapshot);
+	//Points the ObjectData uniform block at a slot, only valid once the frame's object data has been uploaded
+	static void bindObjectData(unsigned int slot);
+	//Draws the (already sorted) command list, skipping binds that are already in place
+	//The snapshot's instances are instancesOffset bytes into instanceBuffer (-1 if they couldn't be written)
+	static void executeCommands(const RenderSnapshot& snapshot, GLuint instanceBuffer, GLintptr instancesOffset);
+	//Makes the mesh's instanced vertex array the first time it's needed
+	static GLuint getInstancedVertexArray(MeshAsset* mesh);
+
+	//The 6 planes of the view (left, right, bottom, top, near, far) in world space, stored as all the x values, then y, z and w, ready for SSE
+	static float frustumPlanes[4][6];
+	static std::atomic<size_t> culledCount, drawnCount;
+
+	//Uniform buffers for the 3 uniform blocks, and how far apart object slots are (OpenGL needs each one to start on an aligned offset)
+	static GLuint frameBuffer, objectBuffer, materialBuffer;
+	static GLint objectStride;
+	//This frame's object data spaced out to objectStride, uploaded in one go before anything is drawn
+	static std::vector<unsigned char> objectStaging;
+	//The materials version last uploaded by the render thread
+	static unsigned int uploadedMaterialsVersion;
+
+	//Simulation thread only
+	static std::vector<Material> materials;
+	static unsigned int materialsVersion;
+
+	static std::vector<ObjectSlot> slots;
+	static std::vector<unsigned int> freeSlots;
+	//Packed array of every object, with the slot each one belongs to and its world matrix (all kept in the same order)
+	static std::vector<DrawObject*> liveObjects;
+	static std::vector<unsigned int> liveSlots;
+	static std::vector<glm::mat4> liveTransforms;
+	//Indices into the packed arrays of objects whose transform changed this frame
+	static std::vector<unsigned int> dirtyTransforms;
+	static std::vector<ObjectHandle> pendingDestroy;
 };
 
 //The class that handles Player Input and moving the player object around the screen
@@ -87,7 +262,7 @@ class PlayerController : public DrawObject
 public:
 	PlayerController();
 	float posX, posY, targetY, velocityY, velocityX;
-	void Setup(const char* tPath, GLuint planeShaderProgram);
+	void Setup(const char* tPath);
 	void Update();
 	void controlUpdate(std::map<char, bool> keyMap, float dt);
 	//The player's collision
@@ -97,38 +272,6 @@ public:
 	std::string* playerScoreText;
 };
 
-//The NoteBlock class
-class NoteTarget : public DrawObject {
-private:
-	//Contains pointers to the GameManager's audio manager and the current player
-	AudioManager* objAudioManager;
-	//Needed to check if noteblock has collided with player
-	CollisionBox colBox;
-	PlayerController* currentPlayer;
-	
-public:
-	//At what second offset should the NoteBlock be "hittable" by the player object
-	float time;
-	float velocity;
-	static std::vector<glm::vec3> noteTargetVertices, noteTargetNormals;
-	static std::vector<glm::vec2> noteTargetUvs;
-	//Note Target Constructor Function
-	NoteTarget(float xPos, float noteKey, float noteTime, float noteLength, float noteVelocity, AudioManager* inAudioManager, PlayerController* playerObject);
-	void Update(); //Override
-};
-
-//Highlights used in game, these show up on screen when the noteblock is close to being "hittable"
-class NoteHighlight : public DrawObject {
-private:
-	AudioManager* audioManager;
-	float highlightTime;
-	float noteTime;
-public:
-	NoteHighlight(float inNoteTime, DrawObject* inParentNote, AudioManager* audioIn);
-	void Update();
-};
-
-
 //Model Manipulation functions
 //These are used to update the modelview on a draw call
 class MatrixFunctions {
@@ -140,5 +283,12 @@ public:
 	static glm::mat4 rotateX(float angle);
 	static glm::mat4 rotateY(float angle);
 	static glm::mat4 rotateZ(float angle);
+
+	//Builds translate(position) * rotateZ * rotateY * rotateX * scale(scale) straight into out, without any matrix multiplies
+	static void composeTRS(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::mat4& out);
+	//Only replaces the translation (last column) of a matrix built by composeTRS
+	static void setTranslation(glm::vec3 position, glm::mat4& out);
+	//a * b using SSE
+	static glm::mat4 multiply(const glm::mat4& a, const glm::mat4& b);
 };
 
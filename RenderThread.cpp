@@ -0,0 +1,372 @@
+#include "RenderThread.h"
+#include "CPUProfiler.h"
+#include "FramePacer.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+//The window GLUT made, and the context (shared with GLUT's) that the render thread draws to it with
+#ifdef _WIN32
+#include <Windows.h>
+HDC renderDeviceContext = nullptr;
+HGLRC renderContext = nullptr;
+#else
+#include <GL/glx.h>
+#include <X11/Xlib.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+Display* renderDisplay = nullptr;
+GLXDrawable renderDrawable = 0;
+GLXContext renderContext = nullptr;
+//The headless benchmark's context, which draws to a pbuffer instead of a window
+EGLDisplay headlessDisplay = EGL_NO_DISPLAY;
+EGLSurface headlessSurface = EGL_NO_SURFACE;
+EGLContext headlessContext = EGL_NO_CONTEXT;
+#endif
+
+//How long the render thread waits for a new snapshot before checking if it should stop
+const std::chrono::milliseconds snapshotWait(100);
+
+//Class variables defined out of scope
+std::thread RenderThread::thread;
+void (*RenderThread::drawFunction)(const RenderSnapshot&) = nullptr;
+RenderSnapshot RenderThread::snapshots[3];
+int RenderThread::buildIndex = 0;
+int RenderThread::readyIndex = 1;
+int RenderThread::drawIndex = 2;
+bool RenderThread::bNewSnapshot = false;
+bool RenderThread::bStopping = false;
+std::mutex RenderThread::snapshotMutex;
+std::condition_variable RenderThread::snapshotPublished;
+std::atomic<unsigned long long> RenderThread::publishedSequence(0);
+unsigned long long RenderThread::drawnSequence = 0;
+float RenderThread::lastDrawMs = 0.f;
+std::condition_variable RenderThread::snapshotDrawn;
+bool RenderThread::bHeadless = false;
+bool RenderThread::bVSync = false;
+bool RenderThread::bSwapped = false;
+std::chrono::steady_clock::time_point RenderThread::swapStart;
+std::chrono::steady_clock::time_point RenderThread::swapEnd;
+std::deque<RenderThread::GLJob> RenderThread::glJobs;
+std::mutex RenderThread::glJobMutex;
+
+void RenderSnapshot::clear()
+{
+	materials.clear();
+	objects.clear();
+	instances.clear();
+	commands.clear();
+	gui.clear();
+	bDrawGui = false;
+	bProfilerOverlay = false;
+	captureFrame = -1;
+}
+
+//Xlib has to be told before it's first used that the window will be used from two threads (GLUT's and the render thread)
+void RenderThread::Init()
+{
+#ifndef _WIN32
+	XInitThreads();
+#endif
+}
+
+bool RenderThread::createHeadlessContext(int width, int height)
+{
+#ifdef _WIN32
+	std::cout << "Headless rendering needs EGL, which is only used on Linux" << std::endl;
+	return false;
+#else
+	headlessDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	bool bInitialised = headlessDisplay != EGL_NO_DISPLAY && eglInitialize(headlessDisplay, &major, &minor);
+	//The default display is usually the X server, without one Mesa can still draw with no display at all
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (!bInitialised && getPlatformDisplay != nullptr) {
+		headlessDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		bInitialised = headlessDisplay != EGL_NO_DISPLAY && eglInitialize(headlessDisplay, &major, &minor);
+	}
+	if (!bInitialised) {
+		std::cout << "Failed to initialise EGL" << std::endl;
+		return false;
+	}
+	//The same formats GLUT is asked for, plus a depth buffer
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(headlessDisplay, configAttributes, &config, 1, &configCount) || configCount == 0) {
+		std::cout << "No EGL config can draw OpenGL to a pbuffer" << std::endl;
+		return false;
+	}
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	headlessSurface = eglCreatePbufferSurface(headlessDisplay, config, surfaceAttributes);
+	//EGL defaults to OpenGL ES, the game uses desktop OpenGL
+	eglBindAPI(EGL_OPENGL_API);
+	headlessContext = eglCreateContext(headlessDisplay, config, EGL_NO_CONTEXT, nullptr);
+	if (headlessSurface == EGL_NO_SURFACE || headlessContext == EGL_NO_CONTEXT || !eglMakeCurrent(headlessDisplay, headlessSurface, headlessSurface, headlessContext)) {
+		std::cout << "Failed to create a headless OpenGL context" << std::endl;
+		return false;
+	}
+	bHeadless = true;
+	return true;
+#endif
+}
+
+bool RenderThread::isHeadless()
+{
+	return bHeadless;
+}
+
+//Sharing means textures, buffers, shaders and programs made in either context can be used in the other
+//Vertex arrays and framebuffers aren't shared, which is why the game's context is made current before anything is created
+bool RenderThread::createWindowContext()
+{
+#ifdef _WIN32
+	renderDeviceContext = wglGetCurrentDC();
+	HGLRC glutContext = wglGetCurrentContext();
+	renderContext = wglCreateContext(renderDeviceContext);
+	//Has to be called before the new context has any objects of its own
+	if (renderContext == nullptr || !wglShareLists(glutContext, renderContext)) {
+		std::cout << "Failed to create the render thread's OpenGL context" << std::endl;
+		return false;
+	}
+	return wglMakeCurrent(renderDeviceContext, renderContext) != FALSE;
+#else
+	renderDisplay = glXGetCurrentDisplay();
+	renderDrawable = glXGetCurrentDrawable();
+	GLXContext glutContext = glXGetCurrentContext();
+	//The new context has to be made with the same visual as the window so it can draw to it
+	XWindowAttributes attributes;
+	if (renderDisplay == nullptr || !XGetWindowAttributes(renderDisplay, renderDrawable, &attributes)) {
+		std::cout << "Failed to create the render thread's OpenGL context" << std::endl;
+		return false;
+	}
+	XVisualInfo visualTemplate = {};
+	visualTemplate.visualid = XVisualIDFromVisual(attributes.visual);
+	int visualCount = 0;
+	XVisualInfo* visual = XGetVisualInfo(renderDisplay, VisualIDMask, &visualTemplate, &visualCount);
+	if (visual != nullptr) {
+		renderContext = glXCreateContext(renderDisplay, visual, glutContext, True);
+		XFree(visual);
+	}
+	if (renderContext == nullptr) {
+		std::cout << "Failed to create the render thread's OpenGL context" << std::endl;
+		return false;
+	}
+	return glXMakeCurrent(renderDisplay, renderDrawable, renderContext) == True;
+#endif
+}
+
+//A context can only be current on one thread at a time, so GLUT's thread lets go of the game's context before the render thread picks it up
+//GLUT's own context is left alone, GLUT makes it current on its thread before every callback
+void RenderThread::Start(void (*drawFrame)(const RenderSnapshot&))
+{
+	drawFunction = drawFrame;
+#ifdef _WIN32
+	wglMakeCurrent(nullptr, nullptr);
+#else
+	if (bHeadless) {
+		eglMakeCurrent(headlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		bStopping = false;
+		thread = std::thread(renderLoop);
+		return;
+	}
+	glXMakeCurrent(renderDisplay, None, nullptr);
+#endif
+	bStopping = false;
+	thread = std::thread(renderLoop);
+}
+
+void RenderThread::Stop()
+{
+	if (!thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(snapshotMutex);
+		bStopping = true;
+	}
+	snapshotPublished.notify_all();
+	snapshotDrawn.notify_all();
+	thread.join();
+}
+
+RenderSnapshot& RenderThread::beginSnapshot()
+{
+	RenderSnapshot& snapshot = snapshots[buildIndex];
+	snapshot.clear();
+	snapshot.sequence = publishedSequence + 1;
+	return snapshot;
+}
+
+//Only the indices are swapped while the lock is held, so publishing never waits for a frame to be drawn
+void RenderThread::publish()
+{
+	{
+		std::lock_guard<std::mutex> lock(snapshotMutex);
+		std::swap(buildIndex, readyIndex);
+		bNewSnapshot = true;
+		publishedSequence = snapshots[readyIndex].sequence;
+	}
+	snapshotPublished.notify_one();
+}
+
+const RenderSnapshot* RenderThread::acquire()
+{
+	std::unique_lock<std::mutex> lock(snapshotMutex);
+	snapshotPublished.wait_for(lock, snapshotWait, [] { return bNewSnapshot || bStopping; });
+	if (bStopping || !bNewSnapshot) {
+		return nullptr;
+	}
+	std::swap(drawIndex, readyIndex);
+	bNewSnapshot = false;
+	return &snapshots[drawIndex];
+}
+
+void RenderThread::queueGLJob(std::function<void()> job)
+{
+	std::lock_guard<std::mutex> lock(glJobMutex);
+	glJobs.push_back({ publishedSequence + 1, job });
+}
+
+//Jobs are queued in order, so this stops at the first one that has to wait for a newer snapshot
+void RenderThread::runGLJobs(unsigned long long sequence)
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::lock_guard<std::mutex> lock(glJobMutex);
+			if (glJobs.empty() || glJobs.front().sequence > sequence) {
+				return;
+			}
+			job = std::move(glJobs.front().job);
+			glJobs.pop_front();
+		}
+		job();
+	}
+}
+
+//A pbuffer has nothing to show, so headless frames just stay in it
+void RenderThread::swapBuffers()
+{
+	swapStart = std::chrono::steady_clock::now();
+#ifdef _WIN32
+	SwapBuffers(renderDeviceContext);
+#else
+	if (bHeadless) {
+		return;
+	}
+	glXSwapBuffers(renderDisplay, renderDrawable);
+#endif
+	//The driver would otherwise queue up frames and return straight away, each queued frame adds a whole refresh before what's drawn is seen
+	//Waiting here means the frame has just been shown when this returns, and the FramePacer makes sure the next frame isn't ready much earlier than it's needed
+	if (bVSync) {
+		glFinish();
+	}
+	swapEnd = std::chrono::steady_clock::now();
+	bSwapped = true;
+}
+
+bool RenderThread::enableVSync()
+{
+#ifdef _WIN32
+	typedef BOOL(WINAPI* SwapIntervalProc)(int interval);
+	SwapIntervalProc swapInterval = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+	return swapInterval != nullptr && swapInterval(1);
+#else
+	//glXGetProcAddress returns something even for functions the driver doesn't have, so the extension list is checked first
+	const char* extensions = glXQueryExtensionsString(renderDisplay, DefaultScreen(renderDisplay));
+	if (extensions == nullptr) {
+		return false;
+	}
+	if (std::strstr(extensions, "GLX_EXT_swap_control") != nullptr) {
+		typedef void (*SwapIntervalProc)(Display* display, GLXDrawable drawable, int interval);
+		SwapIntervalProc swapInterval = (SwapIntervalProc)glXGetProcAddress((const GLubyte*)"glXSwapIntervalEXT");
+		swapInterval(renderDisplay, renderDrawable, 1);
+		return true;
+	}
+	if (std::strstr(extensions, "GLX_MESA_swap_control") != nullptr) {
+		typedef int (*SwapIntervalProc)(unsigned int interval);
+		SwapIntervalProc swapInterval = (SwapIntervalProc)glXGetProcAddress((const GLubyte*)"glXSwapIntervalMESA");
+		return swapInterval(1) == 0;
+	}
+	return false;
+#endif
+}
+
+void RenderThread::waitUntilDrawn(unsigned long long sequence)
+{
+	std::unique_lock<std::mutex> lock(snapshotMutex);
+	snapshotDrawn.wait(lock, [sequence] { return drawnSequence >= sequence || bStopping; });
+}
+
+float RenderThread::getLastDrawMs()
+{
+	std::lock_guard<std::mutex> lock(snapshotMutex);
+	return lastDrawMs;
+}
+
+//Takes the context, then draws every snapshot that arrives until it's told to stop
+void RenderThread::renderLoop()
+{
+#ifdef _WIN32
+	wglMakeCurrent(renderDeviceContext, renderContext);
+#else
+	if (bHeadless) {
+		//The API EGL makes contexts current for is chosen per thread
+		eglBindAPI(EGL_OPENGL_API);
+		eglMakeCurrent(headlessDisplay, headlessSurface, headlessSurface, headlessContext);
+	}
+	else {
+		glXMakeCurrent(renderDisplay, renderDrawable, renderContext);
+	}
+#endif
+	if (!bHeadless) {
+		bVSync = enableVSync();
+		FramePacer::setVSync(bVSync);
+	}
+	PROFILE_THREAD("Render");
+	while (true) {
+		const RenderSnapshot* snapshot = acquire();
+		{
+			std::lock_guard<std::mutex> lock(snapshotMutex);
+			if (bStopping) {
+				break;
+			}
+		}
+		if (snapshot == nullptr) {
+			continue;
+		}
+		runGLJobs(snapshot->sequence);
+		std::chrono::steady_clock::time_point drawStart = std::chrono::steady_clock::now();
+		bSwapped = false;
+		drawFunction(*snapshot);
+		float drawMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - drawStart).count();
+		//Only the time before the swap counts as the cost of drawing, the rest was spent waiting for the display
+		if (bSwapped && !bHeadless) {
+			FramePacer::framePresented(snapshot->inputTime, std::chrono::duration<float, std::milli>(swapStart - drawStart).count(), swapEnd);
+		}
+		{
+			std::lock_guard<std::mutex> lock(snapshotMutex);
+			drawnSequence = snapshot->sequence;
+			lastDrawMs = drawMs;
+		}
+		snapshotDrawn.notify_all();
+	}
+#ifdef _WIN32
+	wglMakeCurrent(nullptr, nullptr);
+#else
+	if (bHeadless) {
+		eglMakeCurrent(headlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+	else {
+		glXMakeCurrent(renderDisplay, None, nullptr);
+	}
+#endif
+}
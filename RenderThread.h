@@ -0,0 +1,116 @@
+#pragma once
+#include "ObjectManager.h"
+#include "GUIManager.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Everything the render thread needs to draw one frame, built by the simulation (the GLUT thread) and never changed once it's been published
+//Only plain data is kept here (matrices, materials, sorted draw commands, GUI quads), so drawing it never has to look at the game's objects
+struct RenderSnapshot {
+	unsigned long long sequence = 0; //Counts up by one for every snapshot that's published
+	bool bLoading = true;
+	float loadingProgress = 0.f;
+	int width = 0, height = 0;
+
+	//The scene
+	FrameData frame;
+	std::vector<Material> materials;
+	unsigned int materialsVersion = 0; //Goes up whenever a material is added, so the render thread knows when to upload them again
+	std::vector<ObjectData> objects;
+	std::vector<glm::vec4> instances;
+	std::vector<RenderCommand> commands; //Already sorted by key
+
+	//The GUI
+	bool bDrawGui = false;
+	GUIDrawList gui;
+	bool bProfilerOverlay = false; //The GPU pass times are on screen, so the render thread records them to the CSV too
+	int captureFrame = -1; //The benchmark frame number if this frame should be read back and saved as a PNG
+	std::chrono::steady_clock::time_point inputTime; //When the pitch and keys this frame shows were read, for the FramePacer's latency estimate
+	int bloomLevels = 4; //How many levels of the bloom chain to use, set by the bloom quality option
+	bool bDynamicResolution = true; //The scene can be drawn smaller than the window if the GPU is too slow (see DynamicResolution)
+
+	//Empties the snapshot so it can be built again, the vectors keep their memory so a snapshot stops allocating after the first few frames
+	void clear();
+};
+
+//The render thread owns the OpenGL context and draws the newest snapshot the simulation has published
+//There are 3 snapshots: one being built by the simulation, one being drawn by the render thread and the newest finished one waiting in between
+//Publishing swaps the built snapshot with the waiting one, and the render thread swaps the waiting one with the one it just drew
+//Neither thread ever waits for the other to finish a frame, if the simulation publishes twice before the render thread is ready the older snapshot is just skipped
+class RenderThread
+{
+public:
+	//Must be called before GLUT is started, some platforms need to be told more than one thread will use the window
+	static void Init();
+	//Instead of a GLUT window, makes an offscreen EGL pbuffer (of width by height) and an OpenGL context that draws to it
+	//Works without a display server or a GPU (Mesa's llvmpipe can provide it)
+	//Only available on Linux, returns false if the context couldn't be made
+	static bool createHeadlessContext(int width, int height);
+	static bool isHeadless();
+	//Makes a second OpenGL context for GLUT's window that shares its objects with GLUT's context, and makes it current instead of GLUT's
+	//Called straight after the window is created, so everything the game makes is made in this context and it can be moved to the render thread
+	//GLUT's own context stays on GLUT's thread, GLUT makes it current again before every callback, which fails if another thread has it
+	//Returns false if the context couldn't be made
+	static bool createWindowContext();
+	//Moves the game's OpenGL context (the window's or the headless one) over to a new thread, which calls drawFrame with every new snapshot
+	//No OpenGL calls can be made on the calling thread after this
+	static void Start(void (*drawFrame)(const RenderSnapshot&));
+	static void Stop();
+
+	//Returns the snapshot the simulation should build next, it's cleared and given the next sequence number
+	static RenderSnapshot& beginSnapshot();
+	//Hands the built snapshot to the render thread
+	static void publish();
+
+	//Runs job on the render thread once it has picked up a snapshot built after this call
+	//Used to delete OpenGL objects, so nothing is deleted while an older snapshot that uses it might still be drawn
+	static void queueGLJob(std::function<void()> job);
+	//Shows the frame that has just been drawn, only called on the render thread
+	//With vsync it waits until the frame is on screen, so the time it returns is when the frame was shown
+	static void swapBuffers();
+
+	//Blocks until the snapshot with this sequence number (or a newer one) has been drawn
+	//Only the headless benchmark uses this, so every frame it builds is drawn exactly once
+	static void waitUntilDrawn(unsigned long long sequence);
+	//How long (in milliseconds) drawing the last snapshot took on the render thread
+	static float getLastDrawMs();
+
+private:
+	static void renderLoop();
+	//Waits for a snapshot newer than the one last drawn, returns nullptr if none arrived in time or the thread is stopping
+	static const RenderSnapshot* acquire();
+	static void runGLJobs(unsigned long long sequence);
+	//Asks the driver to only swap on the display's refresh, returns false if it can't be turned on
+	static bool enableVSync();
+
+	static std::thread thread;
+	static void (*drawFunction)(const RenderSnapshot&);
+	static RenderSnapshot snapshots[3];
+	static int buildIndex, readyIndex, drawIndex;
+	static bool bNewSnapshot, bStopping;
+	static std::mutex snapshotMutex;
+	static std::condition_variable snapshotPublished;
+	static std::atomic<unsigned long long> publishedSequence;
+	//The last snapshot drawn and how long it took, both guarded by snapshotMutex
+	static unsigned long long drawnSequence;
+	static float lastDrawMs;
+	static std::condition_variable snapshotDrawn;
+	static bool bHeadless;
+	//Only used on the render thread, when the last swap started and finished and if the frame being drawn was swapped
+	static bool bVSync, bSwapped;
+	static std::chrono::steady_clock::time_point swapStart, swapEnd;
+
+	struct GLJob {
+		unsigned long long sequence;
+		std::function<void()> job;
+	};
+	static std::deque<GLJob> glJobs;
+	static std::mutex glJobMutex;
+};
@@ -0,0 +1,276 @@
+#include "ShaderManager.h"
+#include "AssetLoader.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sys/stat.h>
+
+//Class variables defined out of scope
+const float ShaderManager::hotReloadIntervalMs = 500.f;
+std::vector<ShaderManager::WatchedProgram> ShaderManager::programs;
+bool ShaderManager::bHotReload = false;
+std::chrono::steady_clock::time_point ShaderManager::lastCheck;
+
+//FNV-1a, a simple hash that's plenty for telling whether anything has changed
+static void hashString(unsigned long long& hash, const char* text)
+{
+	for (const char* c = text; *c != '\0'; c++) {
+		hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+	}
+	//Hashes a separator too, so moving text from the end of one string to the start of the next changes the hash
+	hash = (hash ^ 0xFF) * 1099511628211ull;
+}
+
+//Binaries are only valid on the driver that made them, so the driver's name and version are part of the key
+static unsigned long long programKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	hashString(hash, vertexSource.c_str());
+	hashString(hash, fragmentSource.c_str());
+	const GLenum driverStrings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum name : driverStrings) {
+		const GLubyte* value = glGetString(name);
+		hashString(hash, value != nullptr ? (const char*)value : "");
+	}
+	return hash;
+}
+
+//Program binaries need GL 4.1 (or the extension), and a driver can support them while offering no formats to save in
+static bool programBinariesSupported()
+{
+	if (!GLEW_ARB_get_program_binary && !GLEW_VERSION_4_1) {
+		return false;
+	}
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+void ShaderManager::loadProgram(const char* vertexPath, const char* fragmentPath, std::function<void(GLuint)> onCreated)
+{
+	WatchedProgram watched;
+	watched.vertexPath = vertexPath;
+	watched.fragmentPath = fragmentPath;
+	watched.onCreated = onCreated;
+	watched.vertexStamp = fileStamp(vertexPath);
+	watched.fragmentStamp = fileStamp(fragmentPath);
+	programs.push_back(watched);
+	requestSources(programs.size() - 1);
+}
+
+void ShaderManager::setHotReload(bool bEnabled)
+{
+	bHotReload = bEnabled;
+}
+
+void ShaderManager::update()
+{
+	if (!bHotReload) {
+		return;
+	}
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<float, std::milli>(now - lastCheck).count() < hotReloadIntervalMs) {
+		return;
+	}
+	lastCheck = now;
+	for (size_t i = 0; i < programs.size(); i++) {
+		WatchedProgram& watched = programs[i];
+		if (watched.bLoading) {
+			continue;
+		}
+		long long vertexStamp = fileStamp(watched.vertexPath);
+		long long fragmentStamp = fileStamp(watched.fragmentPath);
+		if (vertexStamp != watched.vertexStamp || fragmentStamp != watched.fragmentStamp) {
+			watched.vertexStamp = vertexStamp;
+			watched.fragmentStamp = fragmentStamp;
+			watched.bLoading = true;
+			std::cout << "Reloading " << watched.vertexPath << " and " << watched.fragmentPath << std::endl;
+			requestSources(i);
+		}
+	}
+}
+
+//The two files can finish reading in either order, so the program is only built once both have arrived
+//The index is used rather than a reference because programs can grow (and move) before the files arrive
+void ShaderManager::requestSources(size_t index)
+{
+	struct ProgramSources {
+		std::string vertexSource, fragmentSource;
+		int filesLoaded = 0;
+	};
+	std::shared_ptr<ProgramSources> sources = std::make_shared<ProgramSources>();
+	std::function<void()> buildIfReady = [sources, index]() {
+		sources->filesLoaded++;
+		if (sources->filesLoaded < 2) {
+			return;
+		}
+		WatchedProgram& watched = programs[index];
+		watched.bLoading = false;
+		GLuint program = buildProgram(watched, sources->vertexSource, sources->fragmentSource);
+		if (program == 0) {
+			if (watched.program != 0) {
+				std::cout << "Keeping the old program until " << watched.fragmentPath << " compiles" << std::endl;
+			}
+			return;
+		}
+		GLuint oldProgram = watched.program;
+		watched.program = program;
+		glUseProgram(program);
+		watched.onCreated(program);
+		//Deleting 0 does nothing, so the first time through is the same
+		glDeleteProgram(oldProgram);
+	};
+	AssetLoader::requestTextFile(programs[index].vertexPath.c_str(), [sources, buildIfReady](const std::string& source) {
+		sources->vertexSource = source;
+		buildIfReady();
+	});
+	AssetLoader::requestTextFile(programs[index].fragmentPath.c_str(), [sources, buildIfReady](const std::string& source) {
+		sources->fragmentSource = source;
+		buildIfReady();
+	});
+}
+
+GLuint ShaderManager::buildProgram(const WatchedProgram& watched, const std::string& vertexSource, const std::string& fragmentSource)
+{
+	bool bCache = programBinariesSupported();
+	std::string cachePath = cachePathFor(watched.vertexPath, watched.fragmentPath);
+	unsigned long long key = 0;
+	if (bCache) {
+		key = programKey(vertexSource, fragmentSource);
+		GLuint program = loadCachedProgram(cachePath, key);
+		if (program != 0) {
+			return program;
+		}
+	}
+
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, watched.vertexPath);
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, watched.fragmentPath);
+	if (vertexShader == 0 || fragmentShader == 0) {
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return 0;
+	}
+	GLuint program = linkProgram(vertexShader, fragmentShader, bCache);
+	if (program != 0 && bCache) {
+		saveCachedProgram(cachePath, key, program);
+	}
+	return program;
+}
+
+GLuint ShaderManager::compileShader(GLenum shaderType, const std::string& source, const std::string& name)
+{
+	GLuint shader = glCreateShader(shaderType);
+	const GLchar* text = source.c_str();
+	glShaderSource(shader, 1, &text, NULL);
+	glCompileShader(shader);
+
+	GLint bCompiled;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+	if (!bCompiled) {
+		GLint logLength = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+		std::string log(logLength + 1, '\0');
+		glGetShaderInfoLog(shader, logLength, NULL, &log[0]);
+		std::cout << "Shader Compile Error in " << name << "\n" << log.c_str() << std::endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+//The shaders aren't needed once the program is linked, deleting them lets the driver free them along with the program
+GLuint ShaderManager::linkProgram(GLuint vertexShader, GLuint fragmentShader, bool bRetrievable)
+{
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	if (bRetrievable) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(program);
+	glDetachShader(program, vertexShader);
+	glDetachShader(program, fragmentShader);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint bLinked;
+	glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+	if (!bLinked) {
+		GLint logLength = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+		std::string log(logLength + 1, '\0');
+		glGetProgramInfoLog(program, logLength, NULL, &log[0]);
+		std::cout << "Shader Link Error\n" << log.c_str() << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+//A cache file that's missing, from an older version, for different source or for another driver is just ignored (and replaced once the program is linked)
+//The driver can still reject a binary (e.g. after an update that kept the same version string), which is why the link status is checked
+GLuint ShaderManager::loadCachedProgram(const std::string& cachePath, unsigned long long key)
+{
+	std::ifstream file(AssetLoader::filePath(cachePath.c_str()), std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+	ProgramCacheHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, "SJPB", 4) != 0 || header.version != cacheVersion || header.key != key) {
+		return 0;
+	}
+	std::vector<char> binary(header.binaryLength);
+	if (!file.read(binary.data(), binary.size())) {
+		return 0;
+	}
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+	if (!bLinked) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ShaderManager::saveCachedProgram(const std::string& cachePath, unsigned long long key, GLuint program)
+{
+	GLint binaryLength = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0) {
+		return;
+	}
+	std::vector<char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+	ProgramCacheHeader header = {};
+	std::memcpy(header.magic, "SJPB", 4);
+	header.version = cacheVersion;
+	header.key = key;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = (unsigned int)binaryLength;
+	//If the folder can't be written to the game still works, it just compiles from source every time
+	std::ofstream file(AssetLoader::filePath(cachePath.c_str()), std::ios::binary | std::ios::trunc);
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), binaryLength);
+}
+
+std::string ShaderManager::cachePathFor(const std::string& vertexPath, const std::string& fragmentPath)
+{
+	size_t vertexStart = vertexPath.find_last_of("\\/") + 1;
+	std::string vertexName = vertexPath.substr(vertexStart, vertexPath.find_last_of('.') - vertexStart);
+	return fragmentPath.substr(0, fragmentPath.find_last_of('.')) + "." + vertexName + ".sjprog";
+}
+
+long long ShaderManager::fileStamp(const std::string& path)
+{
+	struct stat info;
+	if (stat(AssetLoader::filePath(path.c_str()).c_str(), &info) != 0) {
+		return 0;
+	}
+	return (long long)info.st_mtime * 1000003 + (long long)info.st_size;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+//Every program cache file (.sjprog) begins with this header, followed by binaryLength bytes of the driver's program binary
+struct ProgramCacheHeader {
+	char magic[4]; //Always "SJPB"
+	unsigned int version;
+	//A hash of both shaders' source and the driver's name and version, a binary is only valid for the exact same source on the exact same driver
+	unsigned long long key;
+	unsigned int binaryFormat;
+	unsigned int binaryLength;
+};
+
+//Makes the game's shader programs, and remakes them when their files change
+//Compiling and linking every program from source is a large part of starting the game, so once a program has been linked its binary is saved next to its shaders
+//The next launch hands the saved binary straight to the driver, and only compiles from source if the shaders (or the driver) have changed since
+//With hot reload on, the shader files are checked a couple of times a second and a program whose files have changed is rebuilt and swapped in while the game runs
+//If the new version doesn't compile the old program is kept, so a typo doesn't stop the game
+//Everything here runs on the render thread (loadProgram can also be called before the render thread has started)
+class ShaderManager
+{
+public:
+	//Reads both shader files on the loading threads, then makes the program on the render thread and calls onCreated with it
+	//onCreated is called again with the new program every time it's reloaded, the old program is deleted after it returns
+	static void loadProgram(const char* vertexPath, const char* fragmentPath, std::function<void(GLuint)> onCreated);
+	static void setHotReload(bool bEnabled);
+	//Called once a frame, checks whether any shader files have changed if hot reload is on
+	static void update();
+
+	//Compiles one shader, returns 0 (and prints the log) if it didn't compile, name is only used in the log
+	static GLuint compileShader(GLenum shaderType, const std::string& source, const std::string& name);
+	//Links two compiled shaders into a program (and deletes them), returns 0 (and prints the log) if it didn't link
+	static GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader, bool bRetrievable);
+
+	//How often the shader files are checked for changes when hot reload is on
+	const static float hotReloadIntervalMs;
+	const static unsigned int cacheVersion = 1;
+
+private:
+	struct WatchedProgram {
+		std::string vertexPath, fragmentPath;
+		std::function<void(GLuint)> onCreated;
+		GLuint program = 0;
+		//The files' stamps when they were last read
+		long long vertexStamp = 0, fragmentStamp = 0;
+		bool bLoading = true;
+	};
+
+	//Reads both files and then builds (or rebuilds) the program at index
+	static void requestSources(size_t index);
+	//Makes the program from the cache if it can, otherwise from the source (and saves it to the cache), returns 0 if it failed
+	static GLuint buildProgram(const WatchedProgram& watched, const std::string& vertexSource, const std::string& fragmentSource);
+	static GLuint loadCachedProgram(const std::string& cachePath, unsigned long long key);
+	static void saveCachedProgram(const std::string& cachePath, unsigned long long key, GLuint program);
+	//Shaders\\bloom.vert and Shaders\\bloomUpsample.frag -> Shaders\\bloomUpsample.bloom.sjprog
+	static std::string cachePathFor(const std::string& vertexPath, const std::string& fragmentPath);
+	//Changes whenever the file is saved, its modified time plus its size (the time is only to the second, so two saves in a second could have the same time)
+	static long long fileStamp(const std::string& path);
+
+	static std::vector<WatchedProgram> programs;
+	static bool bHotReload;
+	static std::chrono::steady_clock::time_point lastCheck;
+};
@@ -0,0 +1,212 @@
+#include "ShaderProgram.h"
+
+#include <cstdio>
+#include <cstring>
+
+//How many bytes one of a uniform type takes, 0 for types that aren't given change detection
+static unsigned int uniformTypeSize(GLenum type)
+{
+	switch (type) {
+	case GL_FLOAT: case GL_INT: case GL_BOOL:
+	case GL_SAMPLER_2D: case GL_SAMPLER_CUBE:
+		return 4;
+	case GL_FLOAT_VEC2: return 8;
+	case GL_FLOAT_VEC3: return 12;
+	case GL_FLOAT_VEC4: return 16;
+	case GL_FLOAT_MAT3: return 36;
+	case GL_FLOAT_MAT4: return 64;
+	default: return 0;
+	}
+}
+
+//Uniforms that are part of a uniform block have no location, they're set through the block's buffer instead so they aren't in the table
+void ShaderProgram::reflect(GLuint newProgram)
+{
+	program = newProgram;
+	//glProgramUniform needs GL 4.1 (or the extension), without it the program has to be in use to set its uniforms
+	bDirectUniforms = GLEW_ARB_separate_shader_objects || GLEW_VERSION_4_1;
+	uniforms.clear();
+	attributes.clear();
+	values.clear();
+	if (program == 0) {
+		return;
+	}
+
+	GLint count = 0, maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<GLchar> name(maxNameLength + 1);
+	for (GLint i = 0; i < count; i++) {
+		Uniform uniform;
+		GLsizei nameLength = 0;
+		glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &nameLength, &uniform.count, &uniform.type, name.data());
+		uniform.name.assign(name.data(), nameLength);
+		uniform.location = glGetUniformLocation(program, uniform.name.c_str());
+		if (uniform.location < 0) {
+			continue;
+		}
+		size_t arrayStart = uniform.name.find("[0]");
+		if (arrayStart != std::string::npos) {
+			uniform.name.erase(arrayStart);
+		}
+		uniform.valueOffset = (unsigned int)values.size();
+		uniform.valueSize = uniformTypeSize(uniform.type) * uniform.count;
+		uniform.bValueKnown = false;
+		values.resize(values.size() + uniform.valueSize);
+		uniforms.push_back(uniform);
+	}
+
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+	name.assign(maxNameLength + 1, '\0');
+	for (GLint i = 0; i < count; i++) {
+		Attribute attribute;
+		GLint size = 0;
+		GLsizei nameLength = 0;
+		glGetActiveAttrib(program, (GLuint)i, (GLsizei)name.size(), &nameLength, &size, &attribute.type, name.data());
+		attribute.name.assign(name.data(), nameLength);
+		attribute.location = glGetAttribLocation(program, attribute.name.c_str());
+		attributes.push_back(attribute);
+	}
+}
+
+GLuint ShaderProgram::getProgram() const
+{
+	return program;
+}
+
+int ShaderProgram::findUniform(const char* name) const
+{
+	for (size_t i = 0; i < uniforms.size(); i++) {
+		if (uniforms[i].name == name) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+GLint ShaderProgram::getAttributeLocation(const char* name) const
+{
+	for (const Attribute& attribute : attributes) {
+		if (attribute.name == name) {
+			return attribute.location;
+		}
+	}
+	return -1;
+}
+
+bool ShaderProgram::changed(int index, GLenum type, const void* value, unsigned int size)
+{
+	if (index < 0 || index >= (int)uniforms.size()) {
+		return false;
+	}
+	Uniform& uniform = uniforms[index];
+	//Samplers and bools are set the same way as ints
+	GLenum uniformType = uniform.type;
+	if (uniformType == GL_SAMPLER_2D || uniformType == GL_SAMPLER_CUBE || uniformType == GL_BOOL) {
+		uniformType = GL_INT;
+	}
+	if (uniformType != type) {
+		std::printf("ShaderProgram: %s was set with the wrong type\n", uniform.name.c_str());
+		return false;
+	}
+	//Only the first element of an array is set, so only that much of its last value is compared
+	if (size > uniform.valueSize) {
+		return true;
+	}
+	unsigned char* lastValue = &values[uniform.valueOffset];
+	if (uniform.bValueKnown && std::memcmp(lastValue, value, size) == 0) {
+		return false;
+	}
+	std::memcpy(lastValue, value, size);
+	uniform.bValueKnown = true;
+	return true;
+}
+
+//Only used without glProgramUniform, puts the program in use and returns the one that was in use before so it can be put back
+GLint ShaderProgram::useForSet() const
+{
+	GLint previous = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+	if ((GLuint)previous != program) {
+		glUseProgram(program);
+	}
+	return previous;
+}
+
+void ShaderProgram::restoreAfterSet(GLint previous) const
+{
+	if ((GLuint)previous != program) {
+		glUseProgram((GLuint)previous);
+	}
+}
+
+void ShaderProgram::setInt(int uniform, int value)
+{
+	if (changed(uniform, GL_INT, &value, sizeof(value))) {
+		if (bDirectUniforms) {
+			glProgramUniform1i(program, uniforms[uniform].location, value);
+		}
+		else {
+			GLint previous = useForSet();
+			glUniform1i(uniforms[uniform].location, value);
+			restoreAfterSet(previous);
+		}
+	}
+}
+
+void ShaderProgram::setFloat(int uniform, float value)
+{
+	if (changed(uniform, GL_FLOAT, &value, sizeof(value))) {
+		if (bDirectUniforms) {
+			glProgramUniform1f(program, uniforms[uniform].location, value);
+		}
+		else {
+			GLint previous = useForSet();
+			glUniform1f(uniforms[uniform].location, value);
+			restoreAfterSet(previous);
+		}
+	}
+}
+
+void ShaderProgram::setVec2(int uniform, const glm::vec2& value)
+{
+	if (changed(uniform, GL_FLOAT_VEC2, &value, sizeof(value))) {
+		if (bDirectUniforms) {
+			glProgramUniform2f(program, uniforms[uniform].location, value.x, value.y);
+		}
+		else {
+			GLint previous = useForSet();
+			glUniform2f(uniforms[uniform].location, value.x, value.y);
+			restoreAfterSet(previous);
+		}
+	}
+}
+
+void ShaderProgram::setVec3(int uniform, const glm::vec3& value)
+{
+	if (changed(uniform, GL_FLOAT_VEC3, &value, sizeof(value))) {
+		if (bDirectUniforms) {
+			glProgramUniform3f(program, uniforms[uniform].location, value.x, value.y, value.z);
+		}
+		else {
+			GLint previous = useForSet();
+			glUniform3f(uniforms[uniform].location, value.x, value.y, value.z);
+			restoreAfterSet(previous);
+		}
+	}
+}
+
+void ShaderProgram::setMat4(int uniform, const glm::mat4& value)
+{
+	if (changed(uniform, GL_FLOAT_MAT4, &value, sizeof(value))) {
+		if (bDirectUniforms) {
+			glProgramUniformMatrix4fv(program, uniforms[uniform].location, 1, GL_FALSE, &value[0][0]);
+		}
+		else {
+			GLint previous = useForSet();
+			glUniformMatrix4fv(uniforms[uniform].location, 1, GL_FALSE, &value[0][0]);
+			restoreAfterSet(previous);
+		}
+	}
+}
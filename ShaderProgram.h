@@ -0,0 +1,61 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+//A linked program along with a table of its active uniforms and attributes, read from the driver once when the program is made
+//Asking the driver for a uniform's location means hashing its name and looking it up every time, so instead the name is looked up once (findUniform)
+//and the index it returns is kept and used every frame after that
+//Each uniform remembers the last value it was given, setting the same value again doesn't call OpenGL at all
+//The setters use glProgramUniform when the driver has it, so they work whether or not the program is in use (without it the program is put in use just for the set)
+//Only used on the render thread
+class ShaderProgram
+{
+public:
+	//Reads the program's uniforms and attributes, called when the program is made and again whenever it's reloaded
+	//Any indices found before this are no longer valid, so they need finding again
+	void reflect(GLuint program);
+	GLuint getProgram() const;
+
+	//Returns the uniform's index in the table, or -1 if the program doesn't have it (the compiler removes uniforms that aren't used)
+	//Arrays are found by their name without the [0]
+	int findUniform(const char* name) const;
+	//Returns the attribute's location, or -1 if the program doesn't have it
+	GLint getAttributeLocation(const char* name) const;
+
+	//Setting uniform -1 does nothing, the same as OpenGL does with location -1
+	void setInt(int uniform, int value);
+	void setFloat(int uniform, float value);
+	void setVec2(int uniform, const glm::vec2& value);
+	void setVec3(int uniform, const glm::vec3& value);
+	void setMat4(int uniform, const glm::mat4& value);
+
+private:
+	struct Uniform {
+		std::string name;
+		GLint location;
+		GLenum type;
+		GLint count; //More than 1 for arrays
+		//Where the last value set is kept in values, and how many bytes it is
+		unsigned int valueOffset, valueSize;
+		bool bValueKnown; //False until the uniform has been set, the first set is always uploaded
+	};
+	struct Attribute {
+		std::string name;
+		GLint location;
+		GLenum type;
+	};
+
+	//Copies the value over the uniform's last value, returns false if it was already the same (so it doesn't need uploading)
+	bool changed(int uniform, GLenum type, const void* value, unsigned int size);
+	GLint useForSet() const;
+	void restoreAfterSet(GLint previous) const;
+
+	GLuint program = 0;
+	bool bDirectUniforms = false; //True if glProgramUniform can be used
+	std::vector<Uniform> uniforms;
+	std::vector<Attribute> attributes;
+	std::vector<unsigned char> values;
+};
@@ -1,20 +1,22 @@
 #version 330 core
 in vec2 TexCoords;
+in vec4 Colour;
 layout (location = 0) out vec4 color;
 layout (location = 1) out vec4 BrightColor;
 
 uniform sampler2D text;
-uniform vec3 textColor;
-uniform int isText;
 
 void main ()
 {   
-    if (isText == 1) {
+    //Text comes from the font atlas, which only has a red channel for how much of each pixel the character covers
+    if (Colour.a > 0.5) {
         vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-        color = vec4(textColor, 1.0) * sampled;
+        color = vec4(Colour.rgb, 1.0) * sampled;
     }
     else {
         color = texture(text, TexCoords);
     }
+    //The GUI is drawn straight onto the screen after the frame has been tone mapped, so it's tone mapped the same way here to look the same as the rest of the frame
+    color.rgb = vec3(1.0) - exp(-color.rgb);
     BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
 }  
\ No newline at end of file
@@ -1,6 +1,8 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 1) in vec4 colour; // <vec3 colour, 1 for text or 0 for an image>
 out vec2 TexCoords;
+out vec4 Colour;
 
 uniform mat4 textprojection;
 
@@ -8,4 +10,5 @@ void main ()
 {
     gl_Position = textprojection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
+    Colour = colour;
 }  
\ No newline at end of file
@@ -3,15 +3,24 @@
 in vec2 UV;
 in vec3 fragPos;
 in vec3 normal;
+in float instanceOpacity;
+flat in int materialIndex;
 
 uniform sampler2D textureSampler;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
 
-uniform bool bBloom;
-uniform float brightness;
-uniform float opacity;
-uniform float ambient;
+// Set once a frame (binding 0)
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+// Every material in the scene (binding 2), objects pick theirs by index
+// x is opacity, y is ambient, z is bloom brightness, w is 1 if the material has bloom
+#define MAX_MATERIALS 64
+layout (std140) uniform Materials {
+    vec4 materials[MAX_MATERIALS];
+};
 
 // Output
 layout (location = 0) out vec4 fragColor;
@@ -20,6 +29,12 @@ layout (location = 1) out vec4 brightColor;
 
 void main ()
 {
+    vec4 material = materials[materialIndex];
+    float opacity = material.x;
+    float ambient = material.y;
+    float brightness = material.z;
+    bool bBloom = material.w > 0.5f;
+
 	float materialAmbient = 0.3f;
 	float lightAmbient = 0.3f;
 	float materialDiffuse = 1.f;
@@ -28,14 +43,14 @@ void main ()
 	float lightSpecular = 0.1f;
 	float materialShininess = 10.f;
 
-    float dist = length(fragPos - lightPos);
+    float dist = length(fragPos - lightPos.xyz);
     float power = 100 / (dist * dist);
 
     vec4 textureColour = texture(textureSampler, UV);
 
-    vec3 lightRay = normalize(lightPos - fragPos);
-    //vec3 lightRay = normalize(fragPos - lightPos);
-    vec3 viewRay = normalize(viewPos - fragPos);
+    vec3 lightRay = normalize(lightPos.xyz - fragPos);
+    //vec3 lightRay = normalize(fragPos - lightPos.xyz);
+    vec3 viewRay = normalize(viewPos.xyz - fragPos);
     vec3 reflectedRay = reflect(-lightRay, normal);
 
     float diffuse = max(dot(lightRay, normal), 0.0);
@@ -52,10 +67,10 @@ void main ()
     else {
         finalColor = (ambient * textureColour.rgb) + (diffuseColor * power);
     }
-    fragColor = vec4(finalColor, opacity);
+    fragColor = vec4(finalColor, opacity * instanceOpacity);
 
     if (bBloom) {
-		brightColor = vec4(finalColor * brightness, opacity);
+		brightColor = vec4(finalColor * brightness, opacity * instanceOpacity);
 	}
 	else {
 		brightColor = vec4(0.0, 0.0, 0.0, 1.0);
@@ -6,22 +6,47 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 vertexUV;
 layout (location = 2) in vec3 normalVert;
+// Per instance data when drawing notes (xyz position, w opacity)
+layout (location = 3) in vec4 instanceData;
 
 // Shader outputs, if any
 out vec2 UV;
 out vec3 fragPos;
 out vec3 normal;
+out float instanceOpacity;
+flat out int materialIndex;
 
-// Uniform variables
-uniform mat4 modelview;
-uniform mat4 projection;
+// Set once a frame (binding 0)
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec4 lightPos;
+    vec4 viewPos;
+};
+
+// Set for every object (binding 1), the normal matrix is worked out on the CPU once per object instead of once per vertex
+// When drawing instanced, modelview is just the camera and instanceBase is the rotation and scale shared by every instance
+layout (std140) uniform ObjectData {
+    mat4 modelview;
+    mat4 normalMatrix;
+    mat4 instanceBase;
+    ivec4 objectInfo; // x is the material, y is true when drawing instanced
+};
 
 void main() {
-    gl_Position = projection * modelview * vec4(position, 1.0f);
+    mat4 model = modelview;
+    instanceOpacity = 1.0f;
+    if (objectInfo.y != 0) {
+        mat4 instanceTranslation = mat4(1.0f);
+        instanceTranslation[3] = vec4(instanceData.xyz, 1.0f);
+        model = modelview * instanceTranslation * instanceBase;
+        instanceOpacity = instanceData.w;
+    }
+    gl_Position = projection * model * vec4(position, 1.0f);
     //gl_Position = modelview * vec4(position, 1.0f);
     //gl_Position = vec4(position, 1.0f);
     //Color = color; // Just forward this color to the fragment shader
     UV = vertexUV;
     fragPos = position;
-    normal = mat3(transpose(inverse(modelview))) * normalVert;
+    normal = mat3(normalMatrix) * normalVert;
+    materialIndex = objectInfo.x;
 }
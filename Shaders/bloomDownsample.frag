@@ -0,0 +1,29 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+//The next larger level of the bloom chain (or the bright parts of the frame for the first level)
+uniform sampler2D sourceTexture;
+//The part of the source that has been drawn to, smaller than 1 when the frame is drawn at a lower resolution
+uniform vec2 uvScale;
+
+//Keeps every fetch inside the part of the source that's in use, the rest of the texture is left over from a bigger frame
+vec3 sampleSource(vec2 uv, vec2 texel)
+{
+	return texture(sourceTexture, min(uv, uvScale - texel * 0.5)).rgb;
+}
+
+//Each pixel of this level covers 2x2 pixels of the source, the middle sample sits between those 4 and linear filtering averages them
+//The 4 corner samples do the same for the blocks around it, so each pixel blends a 4x4 area of the source in 5 fetches
+void main()
+{
+	vec2 texel = 1.0 / textureSize(sourceTexture, 0);
+	vec2 uv = TexCoords * uvScale;
+	vec3 resultColour = sampleSource(uv, texel) * 4.0;
+	resultColour += sampleSource(uv + vec2(-texel.x, -texel.y), texel);
+	resultColour += sampleSource(uv + vec2(texel.x, -texel.y), texel);
+	resultColour += sampleSource(uv + vec2(-texel.x, texel.y), texel);
+	resultColour += sampleSource(uv + vec2(texel.x, texel.y), texel);
+	FragColor = vec4(resultColour / 8.0, 1.0);
+}
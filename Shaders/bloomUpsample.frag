@@ -0,0 +1,32 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+//The next smaller level of the bloom chain
+uniform sampler2D sourceTexture;
+//The part of the source that has been drawn to, smaller than 1 when the frame is drawn at a lower resolution
+uniform vec2 uvScale;
+
+//Keeps every fetch inside the part of the source that's in use, the rest of the texture is left over from a bigger frame
+vec3 sampleSource(vec2 uv, vec2 texel)
+{
+	return texture(sourceTexture, min(uv, uvScale - texel * 0.5)).rgb;
+}
+
+//Grows the smaller level back up with a tent filter, so the blocky pixels of the small level don't show
+//The 4 samples along the axes are a whole source pixel away, the 4 diagonal ones are half a pixel away and count twice
+void main()
+{
+	vec2 texel = 1.0 / textureSize(sourceTexture, 0);
+	vec2 uv = TexCoords * uvScale;
+	vec3 resultColour = sampleSource(uv + vec2(-texel.x, 0.0), texel);
+	resultColour += sampleSource(uv + vec2(texel.x, 0.0), texel);
+	resultColour += sampleSource(uv + vec2(0.0, -texel.y), texel);
+	resultColour += sampleSource(uv + vec2(0.0, texel.y), texel);
+	resultColour += sampleSource(uv + vec2(-texel.x, -texel.y) * 0.5, texel) * 2.0;
+	resultColour += sampleSource(uv + vec2(texel.x, -texel.y) * 0.5, texel) * 2.0;
+	resultColour += sampleSource(uv + vec2(-texel.x, texel.y) * 0.5, texel) * 2.0;
+	resultColour += sampleSource(uv + vec2(texel.x, texel.y) * 0.5, texel) * 2.0;
+	FragColor = vec4(resultColour / 12.0, 1.0);
+}
@@ -5,12 +5,18 @@ in vec2 TexCoords;
 
 uniform sampler2D screenTexture;
 uniform sampler2D bloomBlur;
+//The part of each texture that has been drawn to, the frame may have been drawn smaller than the window (see DynamicResolution)
+//Linear filtering stretches that part back over the whole screen
+uniform vec2 screenScale;
+uniform vec2 bloomScale;
 
 void main()
 { 
 	const float gamma = 1;
-	vec3 hdrColor = texture(screenTexture, TexCoords).rgb;
-	vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
+	vec2 screenTexel = 1.0 / textureSize(screenTexture, 0);
+	vec2 bloomTexel = 1.0 / textureSize(bloomBlur, 0);
+	vec3 hdrColor = texture(screenTexture, min(TexCoords * screenScale, screenScale - screenTexel * 0.5)).rgb;
+	vec3 bloomColor = texture(bloomBlur, min(TexCoords * bloomScale, bloomScale - bloomTexel * 0.5)).rgb;
 
 	hdrColor += bloomColor;
 	//FragColor = vec4(hdrColor, 1.0);
@@ -10,22 +10,33 @@ int screenWidth = 854;
 //A constant global variable that defines the mathematical constant pi
 //3.1415....
 const double rotpi = 2 * acos(0.0);
-const int kernelSize = 5;
 
 //Time keeping variables
 //dt is used by the audioManager to gauge how much time has passed since audio capture started
-int newt, oldt;
+//The steady clock is used instead of GLUT's elapsed time, which only counts whole milliseconds
+std::chrono::steady_clock::time_point lastFrameTime;
 float dt;
+//When the current frame read the pitch and keys, it goes into the snapshot so the FramePacer can work out how long it took to be seen
+std::chrono::steady_clock::time_point frameInputTime;
+
+//The game is simulated in fixed steps (240 a second) no matter how often it's drawn
+//Time builds up in simulationAccumulator and is spent one step at a time, what's left over decides how far between the last two steps the frame is drawn (simulationAlpha)
+const float simulationStep = 1.f / 240.f;
+//If a frame takes very long (e.g. the window was being dragged) the simulation doesn't try to catch up more than this
+const float maxFrameTime = 0.25f;
+float simulationAccumulator = 0.f;
+float simulationAlpha = 0.f;
+//How many steps ran last frame and how long they took, so the cost of the simulation can be measured on its own
+int simulationStepsLastFrame = 0;
+float simulationMsLastFrame = 0.f;
 
 //This is where the integer locations of all the programIDs
 //Once the program has been created OpenGL gives us a unique (unsigned) integer which we can use in an API call to tell OpenGL we want to use this shader in our rendering pipeline
 //Scroll down to the CreatePrograms function for an explanation of each shader and it's purpose
-GLuint vertexShader, fragmentShader, shaderProgram;
-GLuint textVertexShader, textFragmentShader, textShaderProgram;
-GLuint screenVertex, screenFragment, screenProgram;
-GLuint debugVertex, debugFragment, debugProgram;
-GLuint gaussianVertex, gaussianFragment, gaussianProgram;
-GLuint projectionPos, modelviewPos;
+GLuint shaderProgram;
+ShaderProgram textProgram;
+ShaderProgram screenProgram;
+GLuint bloomDownsampleProgram, bloomUpsampleProgram;
 
 //The projection and modelview are matrices which are defined for use in the vertex shader
 //The modelview describes how the local space vertices should be converted into world space (translation, rotation and scaling)
@@ -33,24 +44,15 @@ GLuint projectionPos, modelviewPos;
 glm::mat4 projection, modelview; 
 std::vector <glm::mat4> modelviewStack;
 
-//Similar to the integers this is where the framebuffer IDs are stored. OpenGL handles these in a similar way
-//Scroll down to the CreateFramebuffers function for an explanation of each framebuffer and its purpose
-GLuint renderFramebuffer;
-GLuint finalFramebuffer[2];
-GLuint gaussianLeftBuffer[2];
-GLuint gaussianRightBuffer[2];
-GLuint debugFramebuffer[2];
-GLuint splitColourBuffers[2];
-
-//OpenGL ID for changing values in the fragment shader
-//Here is where the location for the horizontal boolean value is stored in the gaussian shader program
-//This ID can be used to change the value at this location from the main code
-GLuint gaussianHorizontalPos;
-
-//OpenGL ID for the render buffer object, the vertex array object, and the vertex buffer object
-//Each one is necessary for rendering framebuffers to the screen
-GLuint RBO;
+//Makes the framebuffers each frame draws to, see the display function for the passes it's given
+FrameGraph frameGraph;
+
+//OpenGL ID for the vertex array object and the vertex buffer object
+//Both are necessary for rendering framebuffers to the screen
 GLuint screenVAO, screenVBO;
+//Per frame vertex data is written here on the render thread, 256 KB a frame is over a thousand GUI characters or thousands of notes
+StreamBuffer vertexStream;
+const size_t vertexStreamFrameSize = 256 * 1024;
 
 //This is the audioManager instance that is responsible for recording audio to the capture buffer
 AudioManager audioManager;
@@ -74,47 +76,23 @@ float vertices[6][4] = {
 //A boolean variable that controls whether or not the RenderQueue function for the GUIManager is called
 bool bRenderGui = true;
 
-//Gaussian Functions
-//This function calculates the gaussian distribution for the gaussian blur fragment shader
-float gaussianDistribution(float x, float standardDeviation) {
-	//Because we're normalising the weights in the kernel so they sum to 1, the usual constant the result needs to be multiplied by is not necessary here
-	return exp((-0.5f * x * x) / (standardDeviation * standardDeviation));
-}
-
-//This function updates the gaussian blur kernel inside the gaussian blur fragment shader
-//Higher values of standard deviation give a greater degree of blur while lower values give a much sharper blur
-//The program is needed as an input to update the values at the end of the function
-void updateGaussianKernel(float standardDeviation, GLuint program) {
-	//The program needs to be loaded by OpenGL to update the values
-	glUseProgram(program);
-
-	//Where the gaussian values are stored
-	std::valarray<float> kernelValues;
-	kernelValues.resize(kernelSize);
-	kernelValues[0] = 1.f;
-	float sumValue = 1.f;
-	//Because (when x = 0) is always 1 for out version of the distribution we can avoid this calculation
-	for (int x = 1; x < kernelSize; x++) {
-		float gaussianValue = gaussianDistribution(x, standardDeviation);
-		kernelValues[x] = gaussianValue;
-		//Multiply by two here because the gaussian kernel is symmetrical
-		sumValue += 2 * gaussianValue;
-	}
+//Toggled with R, lowers the resolution the scene is drawn at when the GPU can't keep up (see DynamicResolution)
+bool bDynamicResolution = true;
 
-	//Normalise the kernel values so the sum of all the values (when expanded) is 1
-	kernelValues /= sumValue;
-
-	//Iterate through the kernel updating each value in the gaussian fragment shader's weight array
-	//The weight array are what are used by the shader to calculate the gaussian blur
-	for (int j = 0; j < kernelSize; j++) {
-		//We need to access each weight value individually. So we create the weight location for the weight value we want
-		//So weight[0] is the first value of our kernel
-		std::string weightLocation = "weight[" + std::to_string(j) + "]";
-		GLuint kernelWeightIndexPosition = glGetUniformLocation(program, weightLocation.c_str());
-		//Update the value with the calculated value
-		glUniform1f(kernelWeightIndexPosition, kernelValues[j]);
-	}
-}
+//Toggled with P, shows how long each pass took on the GPU in the top left corner (and records them to GPUProfiler::csvPath)
+bool bShowProfiler = false;
+const float profilerTextScale = 0.4f;
+const float profilerLineHeight = 22.f;
+const GLfloat profilerTextColour[3] = { 1.f, 1.f, 0.f };
+
+//True until every asset queued at startup has loaded, a loading screen is shown until then
+bool bLoading = true;
+//How long (in milliseconds) the AssetLoader may spend uploading to OpenGL each frame, more is allowed while the loading screen is up
+const float loadingUploadBudget = 12.f;
+const float gameplayUploadBudget = 2.f;
+
+//Locations of the screen program's uniforms that say how much of each texture was drawn to
+int screenScaleUniform = -1, bloomScaleUniform = -1, textProjectionUniform = -1;
 
 // This function pushes the specified matrix onto the modelview stack
 void pushMatrix(glm::mat4 mat) {
@@ -141,236 +119,146 @@ void displayFramebuffer() {
 	glBindVertexArray(0);
 	glActiveTexture(GL_TEXTURE0); //Activates the first texture slot
 	//Binds the vertex array and buffer into OpenGL for rendering, we're telling OpenGL we want to render a quad
+	//The quad's vertices never change, so they were put in the buffer once in setupRenderer
 	glBindVertexArray(screenVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, screenVBO);
-	//Buffer in the vertex data of the quad I want to render to the screen.
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
 	//Finally draw it, there are 6 vertices required to draw a quad, 3 for each face (since we're drawing with exclusively triangles).
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
-//I create a handful of framebuffers in the createFramebuffers function, this needs to be specified for every single framebuffer
-//As long as I bind the framebuffer beforehand, I can call this code to setup the framebuffer correctly and improve readability
-void framebufferSettings() {
-	//Creates a texture for the framebuffer that is the same height and width as the screen and stores all RGB and alpha value channels in a 16 bit float (each)
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, screenWidth, screenHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-	//If the framebuffer should ever be rendered at a smaller size, the GPU should use linear interpolation to scale it up or down
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//If the fragment shader ever asks for a pixel that is out of bounds of the texture, it will just wrap around to the other end of the image
-	//S and T are the directions 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-}
+// ---------------------------------------------------------- GLUT FUNCTIONS ------------------------------------------------------------------
 
-//This function is responsible for creating every framebuffer my programme is going to need
-void createFramebuffers() {
-	
-	//The finalframebuffer is where the final image is rendered to, this is the image the end user sees
-	glGenFramebuffers(1, &finalFramebuffer[0]);
-	glGenTextures(1, &finalFramebuffer[1]);
-	glBindFramebuffer(GL_FRAMEBUFFER, finalFramebuffer[0]);
-	glBindTexture(GL_TEXTURE_2D, finalFramebuffer[1]);
-	framebufferSettings();
-	//Adds a texture object to the framebuffer as a colour attachment, whenever an object is rendered it will be drawn to this texture (if the framebuffer is binded)
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, finalFramebuffer[1], 0);
-
-	//The gaussian blur requires two framebuffers that are switched between a handful of times before rendering
-	//The left buffer is concerned with horizontal blurring, the right buffer is for vertical blurring
-	glGenFramebuffers(1, &gaussianLeftBuffer[0]);
-	glGenTextures(1,  &gaussianLeftBuffer[1]);
-	glBindFramebuffer(GL_FRAMEBUFFER, gaussianLeftBuffer[0]);
-	glBindTexture(GL_TEXTURE_2D, gaussianLeftBuffer[1]);
-	framebufferSettings();
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gaussianLeftBuffer[1], 0);
-	glGenFramebuffers(1, &gaussianRightBuffer[0]);
-	glGenTextures(1, &gaussianRightBuffer[1]);
-	glBindFramebuffer(GL_FRAMEBUFFER, gaussianRightBuffer[0]);
-	glBindTexture(GL_TEXTURE_2D, gaussianRightBuffer[1]);
-	framebufferSettings();
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gaussianRightBuffer[1], 0);
-	
-	//This framebuffer was used for debugging purposes, if I wanted to render a framebuffer early, I would bind this framebuffer.
-	//It is no longer used or needed in the code
-	glGenFramebuffers(1, &debugFramebuffer[0]);
-	glGenTextures(1, &debugFramebuffer[1]);
-	glBindFramebuffer(GL_FRAMEBUFFER, debugFramebuffer[0]);
-	glBindTexture(GL_TEXTURE_2D, debugFramebuffer[1]);
-	framebufferSettings();
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, debugFramebuffer[1], 0);
-
-	//This is the framebuffer where everything is initially rendered to
-	//The ObjectManager renders to this framebuffer, this framebuffer is not displayed to the user.
-	glGenFramebuffers(1, &renderFramebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
-	glGenTextures(2, splitColourBuffers);
-	for (unsigned int i = 0; i < 2; i++) {
-		//This section is needed for the gaussian blur
-		//I attach to colour attachments to the renderBuffer, every object is rendered to Colour Attachment 0, but objects that I want blurred get rendered to Colour Attachment 1
-		glBindTexture(GL_TEXTURE_2D, splitColourBuffers[i]);
-		framebufferSettings();
-
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, splitColourBuffers[i], 0);
-	}
-	//This creates the renderbuffer needed to display each framebuffer
-	glGenRenderbuffers(1, &RBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, RBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, screenWidth, screenHeight);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
-	
-	//Tells OpenGL I'm interested in rendering to two textures (or colour attachments)
-	//The colour attachments are how I control what gets rendered to each texture
-	unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-	glDrawBuffers(2, attachments);
-}
-
-// -------------------------------------------------------------	REWRITE THIS CODE -----------------------------------------------------
-//This is the code that loads shaders and compiles them using OpenGL calls.
-GLuint loadShader(GLenum shaderType, string filename) {
-	GLuint shader = glCreateShader(shaderType);
-	string shaderText = readShaderFile(filename);
-
-	const GLchar* c_str = shaderText.c_str();
-	glShaderSource(shader, 1, &c_str, NULL);
-	glCompileShader(shader);
-
-	GLint bCompiled;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
-	if (!bCompiled) {
-		GLint logLength;
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
-		GLchar* log = new GLchar[logLength + 1];
-		glGetShaderInfoLog(shader, logLength, &logLength, log);
-		cout << "Shader Compile Error\n" << log << endl;
-	}
+//Drawn while the AssetLoader is still working, only uses glClear so it doesn't need any shaders or textures to have loaded
+//The progress bar is made by clearing smaller and smaller rectangles of the screen (the scissor test limits what glClear touches)
+void displayLoadingScreen(const RenderSnapshot& snapshot) {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	int barWidth = snapshot.width / 2;
+	int barHeight = 20;
+	int barX = (snapshot.width - barWidth) / 2;
+	int barY = (snapshot.height - barHeight) / 2;
+
+	glEnable(GL_SCISSOR_TEST);
+	//Outline
+	glScissor(barX - 2, barY - 2, barWidth + 4, barHeight + 4);
+	glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(barX, barY, barWidth, barHeight);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	//The filled part of the bar
+	glScissor(barX, barY, (int)(barWidth * snapshot.loadingProgress), barHeight);
+	glClearColor(0.9f, 0.75f, 0.2f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
 
-	return shader;
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	RenderThread::swapBuffers();
 }
 
-//This function creates programs
-//programs are the name for a combination of a vertex and a fragment shader, this tells OpenGL to create a program that I can use later on when rendering and to link them to each other
-GLuint createProgram(GLuint vertexShader, GLuint fragmentShader) {
-	//Creates a program and attaches the compiled vertex and fragment shader to it
-	GLuint program = glCreateProgram();
-	glAttachShader(program, vertexShader);
-	glAttachShader(program, fragmentShader);
-	GLint bLinked;
-	glLinkProgram(program);
-	glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
-
-	if (bLinked) {
-		glUseProgram(program);
+//This function displays a new frame, it runs on the render thread with the newest snapshot the simulation has built
+//Only the snapshot is used here, never the objects or GUI elements themselves, so the simulation can carry on changing them while this draws
+void display(const RenderSnapshot& snapshot) {
+	PROFILE_ZONE("display");
+	//Uploads whatever the loading threads have finished, anything requested after startup (e.g. a model used for the first time) is uploaded a little at a time
+	AssetLoader::processUploads(snapshot.bLoading ? loadingUploadBudget : gameplayUploadBudget);
+	//Only does anything when the game was started with --watch-shaders
+	ShaderManager::update();
+	//A minimised window has no pixels to draw
+	if (snapshot.width <= 0 || snapshot.height <= 0) {
+		return;
 	}
-	else {
-		GLint logLength;
-		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-		GLchar* log = new GLchar[logLength + 1];
-		glGetProgramInfoLog(program, logLength, &logLength, log);
-		cout << "Shader Compile Error\n" << log << endl;
+	if (snapshot.bLoading) {
+		displayLoadingScreen(snapshot);
+		return;
 	}
+	GPUProfiler::beginFrame(snapshot.bProfilerOverlay, snapshot.sequence);
+	//The scene and the bloom are drawn into the bottom left corner of their textures, which is smaller than the window when the GPU is struggling
+	//The textures are always the size of the window, so this doesn't make the frame graph make new ones
+	float renderScale = DynamicResolution::update(snapshot.bDynamicResolution, snapshot.sequence);
+	int renderWidth = std::max((int)(snapshot.width * renderScale), 1);
+	int renderHeight = std::max((int)(snapshot.height * renderScale), 1);
+
+	//Every pass of the frame says what it reads and what it draws to, the frame graph makes (or reuses) the textures and framebuffers they need
+	frameGraph.beginFrame();
+	FrameGraphTextureDesc screenDesc = { snapshot.width, snapshot.height, GL_RGBA16F };
+	//Every object is rendered to sceneColour, but objects that I want blurred also get rendered to sceneBright (the PhongLighting shader's second output)
+	FrameGraphResource sceneColour = frameGraph.createTexture(screenDesc);
+	FrameGraphResource sceneBright = frameGraph.createTexture(screenDesc);
+	FrameGraphResource sceneDepth = frameGraph.createTexture({ snapshot.width, snapshot.height, GL_DEPTH_COMPONENT24 });
+	FrameGraphResource screen = frameGraph.importBackbuffer();
+
+	frameGraph.addPass("Scene", GPU_PASS_SCENE, {}, { sceneColour, sceneBright, sceneDepth }, [&snapshot, renderWidth, renderHeight]() {
+		glViewport(0, 0, (GLsizei)renderWidth, (GLsizei)renderHeight);
+		//Tells OpenGL to clear the screen completely and replace it with black
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); //Clear all information about what colour the image is and clear information about which pixel of the previous frame was closest to the camera
+		//If Object 1 is behind Object 2, but Object 1 is rendered after Object 2. Object 1 will appear on top of Object 2
+		//This feature is provided by OpenGL so that if a pixel is supposed to be behind another object. OpenGL will ignore it
+		glEnable(GL_DEPTH_TEST);
+		//Load in the phong lighting shader
+		glUseProgram(shaderProgram);
+		ObjectManager::drawSnapshot(snapshot, vertexStream);
+		//I don't want the depth test to be enabled for rendering framebuffers, causes the framebuffer to not be seen
+		glDisable(GL_DEPTH_TEST);
+	});
 
-	return program;
-}
-
-//This function loads in a shader file and outputs the entire file as a string
-//This is so it can be compiled later on in the code
-//GLSL code is compiled during runtime unlike C++ code which is precompiled
-string readShaderFile(string filename) {
-	string ret;
-	fstream shaderFile(filename);
-	string nextLine;
-	while (getline(shaderFile, nextLine)) {
-		ret += nextLine + "\n";
-	}
-	return ret;
-}
-
-// ---------------------------------------------------------- GLUT FUNCTIONS ------------------------------------------------------------------
+	//Bloom
+	//sceneBright only has the parts of the frame that should glow, they're blurred and then added back on top of the frame
+	glm::vec2 bloomScale;
+	FrameGraphResource bloom = BloomRenderer::addPasses(frameGraph, sceneBright, snapshot.width, snapshot.height, renderWidth, renderHeight, snapshot.bloomLevels, bloomScale);
 
-//This function displays a new frame
-//This calls the GUIManager and ObjectManager render queues, it also causes a Game update
-void display() {
-	//Binds the framebuffer that I want the ObjectManager to render every object to
-	glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
-	//Tells OpenGL to clear the screen completely and replace it with black
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); //Clear all information about what colour the image is and clear information about which pixel of the previous frame was closest to the camera
-	//If Object 1 is behind Object 2, but Object 1 is rendered after Object 2. Object 1 will appear on top of Object 2
-	//This feature is provided by OpenGL so that if a pixel is supposed to be behind another object. OpenGL will ignore it
-	glEnable(GL_DEPTH_TEST);
-	//Load in the phong lighting shader
-	glUseProgram(shaderProgram);
-
-	GLuint lightPosPos = glGetUniformLocation(shaderProgram, "lightPos");
-	glUniform3f(lightPosPos, player.posX, player.posY+2.f, 0.f);
-
-	GameManager::gameUpdate();
-	ObjectManager::renderQueue();
-
-	if (bRenderGui) {
-		glUseProgram(textShaderProgram);
-		glm::mat4 textProjection = glm::ortho(0.0f, static_cast<float>(screenWidth), 0.0f, static_cast<float>(screenHeight));
-		glUniformMatrix4fv(glGetUniformLocation(textShaderProgram, "textprojection"), 1, GL_FALSE, &textProjection[0][0]);
-		GUIManager::renderQueue();
-		glUseProgram(shaderProgram);
-	}
-	//I don't want the depth test to be enabled for rendering framebuffers, causes the framebuffer to not be seen
-	glDisable(GL_DEPTH_TEST);
-	
-	//Gaussian blur
-	//The guassian blur fragment shader is called repeatedly to blur the image drawn to Colour Attachment 1, switching between blurring horizontally and vertically
-	glUseProgram(gaussianProgram);
-	int ammount = 50;
-	bool firstIteration = true;
-	bool horizontalPass = true;
-	for (int i = 0; i < ammount; i++) {
-		glUniform1i(gaussianHorizontalPos, horizontalPass);
-
-		if (horizontalPass) {
-			glBindFramebuffer(GL_FRAMEBUFFER, gaussianLeftBuffer[0]);
-			if (firstIteration) {
-				glBindTexture(GL_TEXTURE_2D, splitColourBuffers[1]);
-				firstIteration = false;
-			}
-			else {
-				glBindTexture(GL_TEXTURE_2D, gaussianRightBuffer[1]);
-			}
-		}
-		else {
-			glBindFramebuffer(GL_FRAMEBUFFER, gaussianRightBuffer[0]);
-			glBindTexture(GL_TEXTURE_2D, gaussianLeftBuffer[1]);
-		}
+	//This is the final render to the screen
+	//The screen program (vertex shader and fragment shader) combines sceneColour with the blurred sceneBright
+	//This gives the completed bloom effect, and stretches the frame over the whole window if it was drawn smaller
+	glm::vec2 screenScale((float)renderWidth / snapshot.width, (float)renderHeight / snapshot.height);
+	frameGraph.addPass("Composite", GPU_PASS_COMPOSITE, { sceneColour, bloom }, { screen }, [&snapshot, sceneColour, bloom, screenScale, bloomScale]() {
+		glViewport(0, 0, (GLsizei)snapshot.width, (GLsizei)snapshot.height);
+		glUseProgram(screenProgram.getProgram());
+		screenProgram.setVec2(screenScaleUniform, screenScale);
+		screenProgram.setVec2(bloomScaleUniform, bloomScale);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, frameGraph.getTexture(sceneColour));
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, frameGraph.getTexture(bloom));
 		displayFramebuffer();
-		horizontalPass = !horizontalPass;
+	});
+
+	//The GUI is drawn on top at the window's full resolution, so text stays sharp however small the scene was drawn
+	if (snapshot.bDrawGui) {
+		frameGraph.addPass("GUI", GPU_PASS_GUI, {}, { screen }, [&snapshot]() {
+			glUseProgram(textProgram.getProgram());
+			//Only uploaded when the window has changed size
+			textProgram.setMat4(textProjectionUniform, glm::ortho(0.0f, static_cast<float>(snapshot.width), 0.0f, static_cast<float>(snapshot.height)));
+			GUIManager::drawList(snapshot.gui, vertexStream);
+		});
+	}
+	vertexStream.beginFrame();
+	frameGraph.execute();
+	vertexStream.endFrame();
+	GPUProfiler::endFrame();
+	if (snapshot.captureFrame >= 0) {
+		Benchmark::readCapture(snapshot.width, snapshot.height);
 	}
-	
-	//This is the final render to the screen
-	//The screen program (vertex shader and fragment shader) combines the Colour Attachment 0 texture with the blurred Colour Attachment 1 texture
-	//This gives the completed bloom effect
-	glUseProgram(screenProgram);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, splitColourBuffers[0]);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, gaussianRightBuffer[1]);
-	displayFramebuffer();
 	//Clears the vertex buffer and clears the texture buffer
 	glBindVertexArray(0);
 	glBindTexture(GL_TEXTURE_2D, 0);
 	//Swaps the display buffer so the user is finally presented with the image
-	glutSwapBuffers();
-	//Clear any rendering commands in the GPU that may still be being processed
-	glFlush();
+	RenderThread::swapBuffers();
+}
+
+//GLUT needs a display function, but every frame is drawn by the render thread so there's nothing to do when GLUT asks for one
+void windowExposed() {
 }
 
 //The function that is called when the user changes the size of the window in which the game is in
+//The new size goes into the next snapshot, the render thread changes the viewport when it sees it
 void reshape(int x, int y) {
-	glViewport(0, 0, (GLsizei)x, (GLsizei)y);
 	screenHeight = y;
 	screenWidth = x;
-	projection = glm::perspective(GameManager::fovy, (GLfloat)x/ (GLfloat)y, 1.0f, 200.0f);
-	glUniformMatrix4fv(projectionPos, 1, GL_FALSE, &projection[0][0]);
+	projection = glm::perspective(GameManager::fovy, (GLfloat)x/ (GLfloat)y, 1.0f, GameManager::farPlane);
+	//The projection is sent to the phong shader at the start of every frame (ObjectManager::beginFrame)
 }
 
 //Called when the user clicks down on the mouse
@@ -386,43 +274,167 @@ void mouseMotion(int x, int y) {
 	GUIManager::checkCollisions(x, screenHeight - y, 0);
 }
 
+//Called once everything queued at startup has loaded, sets up the parts of the game that need the GUI and shaders to exist
+void finishLoading() {
+	bLoading = false;
+	OptionsManager::Initialise();
+	GUIManager::showMainMenu();
+	//The benchmark has no GLUT timer or microphone
+	if (RenderThread::isHeadless()) {
+		return;
+	}
+	//The time spent loading shouldn't be simulated
+	lastFrameTime = std::chrono::steady_clock::now();
+	//Start capturing audio for pitch calculations
+	audioManager.StartCapture();
+}
+
+//One fixed step of the game: moves the player, updates every object, then moves the notes and checks for hits
+void simulate(float step) {
+	PROFILE_ZONE("simulate");
+	//Keymap contains what keys are being pressed down
+	player.controlUpdate(keyMap, step);
+	ObjectManager::simulate(step);
+	GameManager::gameUpdate(step);
+}
+
+//Copies everything needed to draw the current frame into a snapshot and hands it to the render thread
+//Returns the snapshot's sequence number, captureFrame is only used by the benchmark (see RenderSnapshot)
+unsigned long long publishSnapshot(int captureFrame = -1) {
+	PROFILE_ZONE("publishSnapshot");
+	RenderSnapshot& snapshot = RenderThread::beginSnapshot();
+	unsigned long long sequence = snapshot.sequence;
+	snapshot.captureFrame = captureFrame;
+	snapshot.bLoading = bLoading;
+	snapshot.loadingProgress = AssetLoader::getProgress();
+	snapshot.width = screenWidth;
+	snapshot.height = screenHeight;
+	snapshot.bloomLevels = OptionsManager::getBloomLevels();
+	snapshot.bDynamicResolution = bDynamicResolution;
+	snapshot.inputTime = frameInputTime;
+	if (!bLoading) {
+		//The GUI doesn't share anything with the scene, so it's laid out by a job at the same time
+		JobCounter guiBuilt;
+		snapshot.bDrawGui = bRenderGui || bShowProfiler;
+		snapshot.bProfilerOverlay = bShowProfiler;
+		if (bRenderGui) {
+			JobSystem::run([&snapshot]() { GUIManager::renderQueue(snapshot.gui); }, guiBuilt);
+		}
+		//The projection and the light (which follows just above the player) are the same for every object, so they're sent once a frame
+		ObjectManager::beginFrame(snapshot, projection, player.getInterpolatedPosition(simulationAlpha) + glm::vec3(0.f, 2.f, 0.f));
+		ObjectManager::renderQueue(simulationAlpha);
+		JobSystem::wait(guiBuilt);
+		//The overlay goes on top of the rest of the GUI, so it's added once the GUI job has finished with the draw list
+		if (bShowProfiler) {
+			std::vector<std::string> lines;
+			GPUProfiler::getSummary(lines);
+			char scaleLine[64];
+			std::snprintf(scaleLine, sizeof(scaleLine), "Render scale %d%%%s", (int)(DynamicResolution::getCurrentScale() * 100.f + 0.5f), bDynamicResolution ? "" : " (off)");
+			lines.push_back(scaleLine);
+			char graphLine[64];
+			std::snprintf(graphLine, sizeof(graphLine), "Render targets %.1f MB, %d passes culled", frameGraph.getPoolBytes() / (1024.f * 1024.f), frameGraph.getCulledPassCount());
+			lines.push_back(graphLine);
+			FramePacer::getSummary(lines);
+			float lineY = screenHeight - profilerLineHeight;
+			for (const std::string& line : lines) {
+				GUIManager::addText(snapshot.gui, line, 10.f, lineY, profilerTextScale, profilerTextColour);
+				lineY -= profilerLineHeight;
+			}
+		}
+	}
+	RenderThread::publish();
+	return sequence;
+}
+
+//Moves the player towards the note being sung
+//A note of 0 means no new frequency could be calculated (the capture buffer isn't filled yet, or it didn't dip below the harmony threshold)
+//If the average volume (or gain) was not above 400.f the capture was too quiet, so the note is ignored
+void applyPitch(double note, double volume) {
+	if (note != 0 && volume > 400) {
+		//Equation for calculating the piano key value of a frequency
+		double key = (12 * log2(note / 440.f) + 49);
+		//Can use this to determine the note was being sung
+		key = std::fmod(key, 12);
+		//this is passed on to a static function that calculates the height that the player should be on screen based on the value of the note sung
+		float targetY = AudioManager::getHeightOfNote(key, GameManager::fovy, GameManager::dist);
+		player.targetY = targetY;
+	}
+}
+
+//Run as many simulation steps as fit in the time since the last frame
+void advanceSimulation(float frameTime) {
+	std::chrono::steady_clock::time_point simulationStart = std::chrono::steady_clock::now();
+	simulationAccumulator += std::min(frameTime, maxFrameTime);
+	simulationStepsLastFrame = 0;
+	while (simulationAccumulator >= simulationStep) {
+		simulate(simulationStep);
+		simulationAccumulator -= simulationStep;
+		simulationStepsLastFrame++;
+	}
+	simulationAlpha = simulationAccumulator / simulationStep;
+	simulationMsLastFrame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - simulationStart).count();
+}
+
+void newFrame(int value);
+
+//Asks GLUT to call newFrame again when the FramePacer says the next frame should be built
+//GLUT's timer only counts whole milliseconds, so it's set to go off a millisecond early and FramePacer::waitForWakeTime sleeps the rest
+void scheduleNewFrame(int value) {
+	FramePacer::endFrame();
+	std::chrono::steady_clock::time_point wakeTime = FramePacer::scheduleNextFrame();
+	float waitMs = std::chrono::duration<float, std::milli>(wakeTime - std::chrono::steady_clock::now()).count();
+	glutTimerFunc((unsigned int)std::max(waitMs - 1.f, 0.f), newFrame, value);
+}
+
 //This is the function that is called to indicate a new frame should be rendered
+//It runs as late as it can before the frame is shown (see FramePacer), so the pitch it reads is as fresh as possible
 void newFrame(int value) {
-	float deltaSpeed;
+	PROFILE_ZONE("newFrame");
+	FramePacer::waitForWakeTime();
+	FramePacer::beginFrame();
+	frameInputTime = std::chrono::steady_clock::now();
+
+	//While loading, the only job of a frame is to show how far the loading threads have got (the render thread uploads what they've finished)
+	if (bLoading) {
+		if (!AssetLoader::isBusy()) {
+			finishLoading();
+		}
+		publishSnapshot();
+		scheduleNewFrame(value);
+		return;
+	}
 	
 	//Calculates the time since the last frame in seconds and stores the value in a float
-	newt = glutGet(GLUT_ELAPSED_TIME);
-	dt = (newt - oldt) / 1000.f;
-	oldt = newt;
+	dt = std::chrono::duration<float>(frameInputTime - lastFrameTime).count();
+	lastFrameTime = frameInputTime;
 	
 	//Asks the audio manager if there is a new frequency to be calculated
 	double note, volume;
 	note = 0.f;
 	volume = 0.f;
-	//If the audio manager returns 0, that means that no new frequency can be calculated because the capture buffer isn't filled yet
-	//Or that the frequency calculated did not dip below the harmony threshold, so couldn't return an accurate value
-	//This function also returns a volume, if the average volume (or gain) of the capture buffer was not above 400.f, then we ignore the value because the capture taken was too quiet
 	audioManager.updateFrequency(dt, note, volume);
-	if (note != 0 && volume > 400) {
-		//Equation for calculating the piano key value of a frequency
-		double key = (12 * log2(note / 440.f) + 49);
-		//Can use this to determine the note was being sung
-		key = std::fmod(key, 12);
-		//this is passed on to a static function that calculates the height that the player should be on screen based on the value of the note sung
-		float targetY = AudioManager::getHeightOfNote(key, GameManager::fovy, GameManager::dist);
-		player.targetY = targetY;
-	}
-	//Update the players movement
-	//Keymap contains what keys are being pressed down during this frame, dt is the time since last frame
-	player.controlUpdate(keyMap, dt);
-	//Call the display function
-	glutPostRedisplay();
-	glutTimerFunc(1000.0f / 60.0f, newFrame, value); // waits 16 ms before calling this function again
+	applyPitch(note, volume);
+	advanceSimulation(dt);
+	//Hand the frame to the render thread
+	publishSnapshot();
+	scheduleNewFrame(value);
 }
 
 //Changes the keyMap to true or false depending on if a key has been pressed down or released
 void keyPress(unsigned char key, int x, int y) {
 	keyMap[key] = true;
+	if (key == 'p' || key == 'P') {
+		bShowProfiler = !bShowProfiler;
+	}
+	if (key == 'r' || key == 'R') {
+		bDynamicResolution = !bDynamicResolution;
+	}
+#if CPU_PROFILER_ENABLED
+	//T writes out what every thread has been doing for the last few seconds, for looking into a frame that stuttered
+	if (key == 't' || key == 'T') {
+		CPUProfiler::writeTrace();
+	}
+#endif
 }
 
 void keyUp(unsigned char key, int x, int y) {
@@ -437,72 +449,63 @@ void startGame() {
 
 //Terminates the program (with a 0 to signify no errors occured), the function that is called when quit is pressed from the main menu
 void QuitGame() {
+	AssetLoader::Stop();
 	exit(0);
 }
 
-//Function to load a compiled program, used in the graphics pipeline for rendering to the screen
-GLuint loadProgram(const char* vertexShaderLoc, const char* fragmentShaderLoc) {
-	vertexShader = loadShader(GL_VERTEX_SHADER, vertexShaderLoc);
-	fragmentShader = loadShader(GL_FRAGMENT_SHADER, fragmentShaderLoc);
-	return createProgram(vertexShader, fragmentShader);
-}
-
+//Every program is made (and remade when its files change) by the ShaderManager, which calls the function given with each new program
+//The function sets up the program's uniforms, it's called with the program already in use
 void createPrograms() {
-	//Loads in the gaussian vertex and fragment shaders, this program creates the bloom effect by blurring certain objects on the screen
+	//Loads in the bloom's two programs, these create the bloom effect by blurring certain objects on the screen
 	//This gives them the appearance that they are glowing
-	gaussianProgram = loadProgram("Shaders\\gaussianBlur.vert", "Shaders\\gaussianBlur.frag");
-	glUseProgram(gaussianProgram);
-	//Update the weights of the kernel inside the gaussian blur program, horizontal is a boolean value which dictates whether the function should blur horizontally or vertically
-	updateGaussianKernel(3.f, gaussianProgram);
-	gaussianHorizontalPos = glGetUniformLocation(gaussianProgram, "horizontal");
+	ShaderManager::loadProgram("Shaders\\bloom.vert", "Shaders\\bloomDownsample.frag", [](GLuint program) {
+		bloomDownsampleProgram = program;
+		BloomRenderer::setPrograms(bloomDownsampleProgram, bloomUpsampleProgram);
+	});
+	ShaderManager::loadProgram("Shaders\\bloom.vert", "Shaders\\bloomUpsample.frag", [](GLuint program) {
+		bloomUpsampleProgram = program;
+		BloomRenderer::setPrograms(bloomDownsampleProgram, bloomUpsampleProgram);
+	});
 
 	//Loads the program that is responsible for displaying the final framebuffer to the user
-	screenProgram = loadProgram("Shaders\\screenShader.vert", "Shaders\\screenShader.frag");
-
-	//Because the screenShader combines the bloomed texture and the rendered texture, it needs access to both textures
-	//Here I specify which colour attachment belongs to which texture
-	glUseProgram(screenProgram);
-	GLuint screenTexturePos = glGetUniformLocation(screenProgram, "screenTexture");
-	GLuint bloomBlurPos = glGetUniformLocation(screenProgram, "bloomBlur");
-	glUniform1i(screenTexturePos, 0);
-	glUniform1i(bloomBlurPos, 1);
+	ShaderManager::loadProgram("Shaders\\screenShader.vert", "Shaders\\screenShader.frag", [](GLuint program) {
+		screenProgram.reflect(program);
+		//Because the screenShader combines the bloomed texture and the rendered texture, it needs access to both textures
+		//Here I specify which colour attachment belongs to which texture
+		screenProgram.setInt(screenProgram.findUniform("screenTexture"), 0);
+		screenProgram.setInt(screenProgram.findUniform("bloomBlur"), 1);
+		screenScaleUniform = screenProgram.findUniform("screenScale");
+		bloomScaleUniform = screenProgram.findUniform("bloomScale");
+	});
 
 	//Program responsible for displaying text (and all GUI Elements)
 	//Uses orthogonal projection instead of perspective projection (like the objects in the scene). (Orthogonal projection makes it so that no matter how far away an object is from the screen, it's the same size)
-	textShaderProgram = loadProgram("Shaders\\GUIShader.vert", "Shaders\\GUIShader.frag");
-	glm::mat4 textProjection = glm::ortho(0.0f, static_cast<float>(500.0f), 0.0f, static_cast<float>(500.0f));
-
-	glUniformMatrix4fv(glGetUniformLocation(textShaderProgram, "textprojection"), 1, GL_FALSE, &textProjection[0][0]);
-	//shaderProgram = loadProgram("vert.vert", "frag.frag");
-	shaderProgram = loadProgram("Shaders\\PhongLighting.vert", "Shaders\\PhongLighting.frag");
-
-	// Get the positions of the uniform variables
-	projectionPos = glGetUniformLocation(shaderProgram, "projection");
-	modelviewPos = glGetUniformLocation(shaderProgram, "modelview");
-	// Pass the projection and modelview matrices to the shader
-	glUniformMatrix4fv(projectionPos, 1, GL_FALSE, &projection[0][0]);
-	glUniformMatrix4fv(modelviewPos, 1, GL_FALSE, &(modelview)[0][0]);
+	ShaderManager::loadProgram("Shaders\\GUIShader.vert", "Shaders\\GUIShader.frag", [](GLuint program) {
+		textProgram.reflect(program);
+		//The projection is set to the window's size every frame before the GUI is drawn
+		//The text colour and whether a quad is text come from its vertices, so the GUI doesn't need any other uniforms
+		textProjectionUniform = textProgram.findUniform("textprojection");
+	});
+
+	ShaderManager::loadProgram("Shaders\\PhongLighting.vert", "Shaders\\PhongLighting.frag", [](GLuint program) {
+		shaderProgram = program;
+		glUseProgram(shaderProgram);
+		//The matrices, light and materials are all in uniform blocks which the ObjectManager sets up
+		ObjectManager::Init(shaderProgram);
+	});
 }
 
-//This is the function that is called when the program is executed
-//argc and argv are optional arguments that can be passed through if the program is executed from the command line
-//Because I don't expect this to happen I assume both these arguments will be empty
-
-//The main function is in charge of instantiating glut and creating the window and calling the initialisation of the other classes
-int main(int argc, char** argv) {
-	//Inititates glut and allows us to create the window
-	glutInit(&argc, argv);
-	//We tell glut that we want to use a double buffer, this means we can draw to one buffer while another buffer is being drawn
-	//We also tell glut that we want our display to have a Red, Green, Blue, and alpha channel
-	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
-
-	glutInitWindowSize(screenWidth, screenHeight);
-	glutCreateWindow("Space Jam");
-	//Create the window and prints to the console if anything went wrong
-	GLenum error = glewInit();
-	if (error != GLEW_OK) {
-		cout << "Error in creating window";
+//Called on the render thread with the GPU times of each frame once they've been read back
+void gpuFrameTimed(unsigned long long sequence, const float* passTimes) {
+	DynamicResolution::addFrameTime(sequence, passTimes[GPU_PASS_COUNT]);
+	FramePacer::addGPUFrameTime(passTimes[GPU_PASS_COUNT]);
+	if (RenderThread::isHeadless()) {
+		Benchmark::recordGPUFrame(sequence, passTimes);
 	}
+}
+
+//Sets up OpenGL and starts everything the game needs before the first frame, called once the context has been made (by GLUT or the benchmark)
+void setupRenderer() {
 	//When we clear the screen what do we write over the buffer with, tells OpenGL I want an empty buffer to completely black and transparent
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 	
@@ -512,9 +515,13 @@ int main(int argc, char** argv) {
 	glGenBuffers(1, &screenVBO);
 	glBindVertexArray(screenVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, screenVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+	glBindVertexArray(0);
+
+	//Holds everything that's drawn once and thrown away (the notes' instances and the GUI's quads)
+	vertexStream.Create(vertexStreamFrameSize);
 
 	//Describes how OpenGL should operate when drawing objects
 	glDepthFunc(GL_LESS);
@@ -523,19 +530,155 @@ int main(int argc, char** argv) {
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_CULL_FACE);
 
-	//Creates the Framebuffers and the shader programs
-	createFramebuffers();
+	//The bloom's passes draw with the same quad as the screen program
+	BloomRenderer::Init(displayFramebuffer);
+	GPUProfiler::setFrameCallback(gpuFrameTimed);
+
+	//Starts the loading threads, everything below only queues work for them so the window opens straight away
+	//Stop is called on exit so the threads have finished before the program closes
+	AssetLoader::Start();
+	atexit(AssetLoader::Stop);
+	//The job system's workers split up the simulation thread's per frame work
+	JobSystem::Start();
+	atexit(JobSystem::Stop);
 	createPrograms();
 
 	//Class initialisation functions
-	player.Setup("Textures\\goldenPlane2.png", shaderProgram);
-	ObjectManager::Init(shaderProgram);
-	GUIManager::Setup(textShaderProgram);
-	OptionsManager::Initialise();
+	player.Setup("Textures\\goldenPlane2.png");
+	NoteField::Setup();
+	GUIManager::Setup();
+}
+
+//The objects that are always in the scene
+void setupScene() {
+	//Adds new objects to the scene to be rendered
+	DrawObject* background = new DrawObject("Models\\nightSkyObj.obj", "Textures\\nightsky.png", false, 1.f, 1.f, false, glm::vec3(0.f, 4.f, 0.0f), glm::vec3(4.f, 4.f, 4.f), glm::vec3(0.f, rotpi, 0.f), glm::vec3(1.f, 1.f, 1.f));
+	DrawObject* MoonObj = new DrawObject("Models\\moon.obj", "Textures\\moon.png", false, 1.f, 1.f, true, glm::vec3(50.f, 50.f, -100.f), glm::vec3(30.f, 30.f, 30.f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.f, 1.f, 1.f));
+	MoonObj->setRotationalVelocity(glm::vec3(0.01f, 0.1f, 0.0f));
+	ObjectManager::addObject(background);
+	ObjectManager::addObject(MoonObj);
+}
+
+//Draws the benchmark instead of running the game, returns the exit code
+//The simulation waits for every frame to be drawn before building the next, so no frame is skipped and each one's times can be recorded
+int runHeadless() {
+	if (!RenderThread::createHeadlessContext(Benchmark::width, Benchmark::height)) {
+		return 1;
+	}
+	//GLEW also looks for GLX, which isn't there without an X server, but it has loaded the OpenGL functions by then
+	GLenum error = glewInit();
+	if (error != GLEW_OK && error != GLEW_ERROR_NO_GLX_DISPLAY) {
+		cout << "Failed to initialise GLEW" << endl;
+		return 1;
+	}
+	reshape(Benchmark::width, Benchmark::height);
+	setupRenderer();
+	setupScene();
+	if (!Benchmark::loadPitchTrack()) {
+		return 1;
+	}
+	//Every benchmark frame is drawn at the same size, so runs can be compared
+	bDynamicResolution = false;
+	RenderThread::Start(display);
+	atexit(RenderThread::Stop);
+
+	//Loading is drawn the same way as in the game, but isn't timed
+	while (bLoading) {
+		if (!AssetLoader::isBusy()) {
+			finishLoading();
+		}
+		RenderThread::waitUntilDrawn(publishSnapshot());
+	}
+	GUIManager::showGameGUI();
+	GameManager::startGame(Benchmark::chartPath.c_str(), nullptr, &player);
+
+	//The last few frames aren't recorded, they're only drawn so the GPU times of the frames before them are read back
+	for (int frame = 0; frame < Benchmark::frameCount + GPUProfiler::profilerFrames; frame++) {
+		bool bRecorded = frame < Benchmark::frameCount;
+		bool bCaptured = bRecorded && Benchmark::isCaptureFrame(frame);
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		double note, volume;
+		Benchmark::samplePitch(GameManager::songTime, note, volume);
+		applyPitch(note, volume);
+		advanceSimulation(Benchmark::frameTime);
+		unsigned long long sequence = publishSnapshot(bCaptured ? frame : -1);
+		float simulationMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+		RenderThread::waitUntilDrawn(sequence);
+		if (bRecorded) {
+			Benchmark::recordFrame(frame, sequence, simulationMs, RenderThread::getLastDrawMs(), bCaptured);
+		}
+		if (bCaptured) {
+			Benchmark::writeCapture(frame);
+		}
+	}
+	RenderThread::Stop();
+	Benchmark::writeResults();
+	return 0;
+}
+
+//This is the function that is called when the program is executed
+//argc and argv are optional arguments that can be passed through if the program is executed from the command line
+//--cook cooks the textures and --headless runs the benchmark, instead of starting the game (--watch-shaders starts it with shader hot reload)
+//The main function is in charge of instantiating glut and creating the window and calling the initialisation of the other classes
+int main(int argc, char** argv) {
+	//Running the game with --cook [rgba|bc1|bc3|bc7] cooks every png in the Textures folder and then exits
+	//No window is needed for this because the textures are compressed on the CPU
+	if (argc > 1 && std::string(argv[1]) == "--cook") {
+		CookedFormat format = CookedFormat::BC3;
+		if (argc > 2 && !TextureCooker::parseFormat(argv[2], format)) {
+			cout << "Unknown texture format " << argv[2] << ", expected rgba, bc1, bc3 or bc7" << endl;
+			return 1;
+		}
+		int cooked = TextureCooker::cookDirectory("Textures", format);
+		cout << "Cooked " << cooked << " textures" << endl;
+		return 0;
+	}
 
+#if CPU_PROFILER_ENABLED
+	//Registered first so it runs last, after every other thread has stopped
+	PROFILE_THREAD("Simulation");
+	atexit(CPUProfiler::writeTrace);
+#endif
+
+	//Running the game with --headless draws a benchmark without a window, see Benchmark.h
+	if (argc > 1 && std::string(argv[1]) == "--headless") {
+		if (!Benchmark::parseArguments(argc, argv, 2)) {
+			return 1;
+		}
+		return runHeadless();
+	}
+
+	//Running the game with --watch-shaders reloads any shader as soon as its file is saved
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--watch-shaders") {
+			ShaderManager::setHotReload(true);
+		}
+	}
+
+	//Inititates glut and allows us to create the window
+	RenderThread::Init();
+	glutInit(&argc, argv);
+	//We tell glut that we want to use a double buffer, this means we can draw to one buffer while another buffer is being drawn
+	//We also tell glut that we want our display to have a Red, Green, Blue, and alpha channel
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+
+	glutInitWindowSize(screenWidth, screenHeight);
+	glutCreateWindow("Space Jam");
+	//The game draws with its own context rather than GLUT's, so the render thread can take it later
+	if (!RenderThread::createWindowContext()) {
+		return 1;
+	}
+	//Create the window and prints to the console if anything went wrong
+	GLenum error = glewInit();
+	if (error != GLEW_OK) {
+		cout << "Error in creating window";
+	}
+	setupRenderer();
+	FramePacer::audioLatencyMs = AudioManager::getAnalysisLatencyMs();
 	//Glut manages most user input, these commands tell glut what functions to call on an input
 	glutSetKeyRepeat(GLUT_KEY_REPEAT_OFF);
-	glutDisplayFunc(display);
+	glutDisplayFunc(windowExposed);
 	glutReshapeFunc(reshape);
 	glutMouseFunc(mouse);
 	glutPassiveMotionFunc(mouseMotion);
@@ -544,15 +687,12 @@ int main(int argc, char** argv) {
 	glutKeyboardFunc(keyPress);
 	glutKeyboardUpFunc(keyUp);
 
-	GUIManager::showMainMenu();
+	setupScene();
 
-	//Adds new objects to the scene to be rendered
-	DrawObject* background = new DrawObject("Models\\nightSkyObj.obj", "Textures\\nightsky.png", false, 1.f, 1.f, false, glm::vec3(0.f, 4.f, 0.0f), glm::vec3(4.f, 4.f, 4.f), glm::vec3(0.f, rotpi, 0.f), glm::vec3(1.f, 1.f, 1.f));
-	DrawObject* MoonObj = new DrawObject("Models\\moon.obj", "Textures\\moon.png", false, 1.f, 1.f, true, glm::vec3(50.f, 50.f, -100.f), glm::vec3(30.f, 30.f, 30.f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.f, 1.f, 1.f));
-	MoonObj->setRotationalVelocity(glm::vec3(0.01f, 0.1f, 0.0f));
-	
-	//Start capturing audio for pitch calculations
-	audioManager.StartCapture();
+	//Everything from here on is drawn by the render thread, which takes over the game's OpenGL context
+	//Stop is registered after the AssetLoader's so it runs first, the render thread may still be uploading
+	RenderThread::Start(display);
+	atexit(RenderThread::Stop);
 
 	//This command tells glut to start calling the newFrame function
 	glutMainLoop();
@@ -569,6 +709,14 @@ std::vector<std::string> OptionsManager::samplesOptionsText = {
 	"4096 Samples",
 	"512 Samples"
 };
+//The bloom quality options, in the same order as BloomRenderer::qualityLevels
+buttonGUI* OptionsManager::bloomGUI = nullptr;
+int OptionsManager::bloomOptionIndex = 1;
+std::vector<std::string> OptionsManager::bloomOptionsText = {
+	"Low",
+	"Medium",
+	"High"
+};
 
 //In this function we define the function pointers for each function
 //So when the start button is clicked the start game function is called
@@ -583,6 +731,10 @@ void OptionsManager::Initialise()
 	GUIManager::samplesOptionRightClick->setClickFunction(IncrementSamplesOption);
 	GUIManager::samplesBackClick->setClickFunction(GUIManager::showMainMenu);
 	samplesGUI = GUIManager::samplesOptionText;
+	GUIManager::bloomOptionLeftClick->setClickFunction(DecrementBloomOption);
+	GUIManager::bloomOptionRightClick->setClickFunction(IncrementBloomOption);
+	bloomGUI = GUIManager::bloomOptionText;
+	bloomGUI->text = bloomOptionsText[bloomOptionIndex];
 
 	//Here we assign the string pointer of the score button gui to the player score text
 	//This is what increments when a note is hit
@@ -602,3 +754,21 @@ void OptionsManager::DecrementSamplesOption()
 	samplesOptionIndex = (samplesOptionIndex - 1 + samplesOptionsText.size()) % samplesOptionsText.size();
 	samplesGUI->text = samplesOptionsText[samplesOptionIndex];
 }
+
+//The bloom options don't wrap around, Low and High are the ends of the list
+void OptionsManager::IncrementBloomOption()
+{
+	bloomOptionIndex = std::min(bloomOptionIndex + 1, (int)bloomOptionsText.size() - 1);
+	bloomGUI->text = bloomOptionsText[bloomOptionIndex];
+}
+
+void OptionsManager::DecrementBloomOption()
+{
+	bloomOptionIndex = std::max(bloomOptionIndex - 1, 0);
+	bloomGUI->text = bloomOptionsText[bloomOptionIndex];
+}
+
+int OptionsManager::getBloomLevels()
+{
+	return BloomRenderer::qualityLevels[bloomOptionIndex];
+}
@@ -3,6 +3,19 @@
 #pragma once
 
 #include "GameManager.h"
+#include "TextureCooker.h"
+#include "AssetLoader.h"
+#include "RenderThread.h"
+#include "GPUProfiler.h"
+#include "CPUProfiler.h"
+#include "Benchmark.h"
+#include "BloomRenderer.h"
+#include "FrameGraph.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "StreamBuffer.h"
+#include "ShaderManager.h"
+#include "ShaderProgram.h"
 
 #include <iostream>
 #include <string>
@@ -16,9 +29,11 @@
 #include <iostream>
 #include <string>
 #include <stb/stb_image.h>
-
-
-std::string readShaderFile(std::string filename);
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
 
 //The OptionsManager is in charge of changing values when the user changes a setting in the Options Menu
 //This class also defines all the button behaviours for every GUI Element on the screen
@@ -27,9 +42,16 @@ private:
 	static int samplesOptionIndex;
 	static buttonGUI* samplesGUI;
 	static std::vector<std::string> samplesOptionsText;
+	static int bloomOptionIndex;
+	static buttonGUI* bloomGUI;
+	static std::vector<std::string> bloomOptionsText;
 public:
 	static void Initialise();
 	static void IncrementSamplesOption();
 	static void DecrementSamplesOption();
+	static void IncrementBloomOption();
+	static void DecrementBloomOption();
+	//How many levels of the bloom chain the chosen bloom quality uses
+	static int getBloomLevels();
 };
 
@@ -0,0 +1,129 @@
+#include "StreamBuffer.h"
+
+#include <cstdio>
+#include <cstring>
+
+//How long to wait on a fence before checking again (1 second), the wait only times out if the GPU has stopped responding
+const GLuint64 fenceTimeout = 1000000000;
+
+void StreamBuffer::Create(size_t size)
+{
+	frameSize = size;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (GLEW_ARB_buffer_storage || GLEW_VERSION_4_4) {
+		//Coherent means anything written into the mapping can be seen by the GPU without having to flush it
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, frameSize * framesInFlight, nullptr, flags);
+		mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, frameSize * framesInFlight, flags);
+		bPersistent = mapped != nullptr;
+		if (!bPersistent) {
+			//Storage made with glBufferStorage can't be resized, so a new buffer is needed for the fallback
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		}
+	}
+	if (!bPersistent) {
+		//Every frame gets new memory, so the buffer only ever has to hold one frame
+		glBufferData(GL_ARRAY_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::beginFrame()
+{
+	head = 0;
+	if (bPersistent) {
+		if (fences[frame] != nullptr) {
+			//Normally the fence was passed long ago, this only waits if the GPU is more than framesInFlight frames behind
+			while (glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout) == GL_TIMEOUT_EXPIRED) {}
+			glDeleteSync(fences[frame]);
+			fences[frame] = nullptr;
+		}
+	}
+	else {
+		//Passing NULL gives the buffer new memory, the old memory is kept by the driver until the draws using it have finished
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+void StreamBuffer::endFrame()
+{
+	if (bPersistent) {
+		fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		frame = (frame + 1) % framesInFlight;
+	}
+}
+
+GLintptr StreamBuffer::write(const void* data, size_t size, size_t alignment)
+{
+	GLintptr offset;
+	void* destination = map(size, alignment, offset);
+	if (destination != nullptr) {
+		std::memcpy(destination, data, size);
+		unmap();
+	}
+	return offset;
+}
+
+void* StreamBuffer::map(size_t size, size_t alignment, GLintptr& offset)
+{
+	size_t start = (head + alignment - 1) & ~(alignment - 1);
+	if (size > frameSize) {
+		std::printf("StreamBuffer: %u bytes don't fit in a %u byte frame\n", (unsigned int)size, (unsigned int)frameSize);
+		offset = -1;
+		return nullptr;
+	}
+	if (start + size > frameSize) {
+		//The frame has written more than it was given, so it starts again from the beginning of its part
+		//The draws that used the beginning might not have happened yet, so this has to wait for them (or orphan the buffer again), which is slow
+		if (!bOverflowWarned) {
+			std::printf("StreamBuffer: a frame wrote more than %u bytes, the buffer should be made bigger\n", (unsigned int)frameSize);
+			bOverflowWarned = true;
+		}
+		if (bPersistent) {
+			glFinish();
+		}
+		else {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferData(GL_ARRAY_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+		}
+		start = 0;
+	}
+	if (bPersistent) {
+		head = start + size;
+		offset = (GLintptr)(frame * frameSize + start);
+		return mapped + offset;
+	}
+	//Unsynchronized is safe because nothing this frame has drawn from this range yet, and last frame's draws are using the orphaned memory
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	void* destination = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)start, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	//If the map failed nothing can be written, so the caller is given -1 (the same as data that doesn't fit) and the range stays free
+	if (destination == nullptr) {
+		offset = -1;
+		return nullptr;
+	}
+	head = start + size;
+	offset = (GLintptr)start;
+	return destination;
+}
+
+void StreamBuffer::unmap()
+{
+	if (!bPersistent) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+}
+
+GLuint StreamBuffer::getBuffer() const
+{
+	return buffer;
+}
+
+bool StreamBuffer::isPersistent() const
+{
+	return bPersistent;
+}
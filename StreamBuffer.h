@@ -0,0 +1,44 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <cstddef>
+
+//A buffer for data that's only drawn once (the GUI's quads, the notes' instances), written into a ring instead of uploaded one draw at a time
+//Uploading into the same small buffer before every draw makes the driver wait for (or copy around) the last draw that used it
+//Instead each frame writes everything it needs into its own part of one big buffer, and draws from the offsets it was written at
+//The buffer is split into framesInFlight parts, a part is only written again once a fence says the GPU has finished the frame that used it
+//With GL_ARB_buffer_storage the buffer stays mapped the whole time and data is copied straight in
+//Without it, the buffer is given new memory (orphaned) at the start of every frame and each write maps just the range it needs
+//Only used on the render thread
+class StreamBuffer
+{
+public:
+	//Makes the buffer, frameSize is how many bytes each frame can write before it has to wait for the GPU
+	void Create(size_t frameSize);
+	//Called before anything is written for a frame, waits if the GPU is still using this frame's part of the buffer
+	void beginFrame();
+	//Fences everything written this frame, called once the frame's draws have been submitted
+	void endFrame();
+	//Copies size bytes into the buffer and returns the offset they're at, the offset is a multiple of alignment (which has to be a power of 2)
+	//Returns -1 if size is more than a whole frame's part of the buffer, or the buffer couldn't be mapped
+	GLintptr write(const void* data, size_t size, size_t alignment);
+	//The same as write, but gives back somewhere to write the data to instead of copying it, for data that has to be gathered up first
+	//unmap has to be called after writing and before drawing, returns nullptr (with offset -1) if size is too big or the map failed
+	void* map(size_t size, size_t alignment, GLintptr& offset);
+	void unmap();
+	GLuint getBuffer() const;
+	bool isPersistent() const;
+
+	const static int framesInFlight = 3;
+
+private:
+	GLuint buffer = 0;
+	bool bPersistent = false;
+	char* mapped = nullptr;
+	size_t frameSize = 0;
+	int frame = 0;
+	//Where the next write goes, from the start of the current frame's part
+	size_t head = 0;
+	GLsync fences[framesInFlight] = {};
+	bool bOverflowWarned = false;
+};
@@ -0,0 +1,614 @@
+#define NOMINMAX
+#include "TextureCooker.h"
+
+#include <stb/stb_image.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//Increment this whenever the layout of the cooked file changes, old files will then be ignored instead of being loaded incorrectly
+const unsigned int cookedTextureVersion = 2;
+
+//BC7 interpolation weights for 4 bit indices (out of 64), defined by the BC7 specification
+const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+void TextureCooker::unmapFile(MappedFile& mapped) {
+#ifdef _WIN32
+	if (mapped.data) { UnmapViewOfFile(mapped.data); }
+	if (mapped.mapping) { CloseHandle(mapped.mapping); }
+	if (mapped.file) { CloseHandle(mapped.file); }
+	mapped.mapping = nullptr;
+	mapped.file = nullptr;
+#else
+	if (mapped.data) { munmap((void*)mapped.data, mapped.size); }
+#endif
+	mapped.data = nullptr;
+	mapped.size = 0;
+}
+
+//Maps a whole file into memory as read only, returns false if the file doesn't exist
+bool TextureCooker::mapFile(const char* path, MappedFile& mapped) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+	mapped.file = file;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mapped.file, &fileSize) || fileSize.QuadPart == 0) { unmapFile(mapped); return false; }
+	mapped.size = (size_t)fileSize.QuadPart;
+	mapped.mapping = CreateFileMappingA(mapped.file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapped.mapping == NULL) { unmapFile(mapped); return false; }
+	mapped.data = static_cast<const unsigned char*>(MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!mapped.data) { unmapFile(mapped); return false; }
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) { return false; }
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0) { close(fd); return false; }
+	void* view = mmap(nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) { return false; }
+	mapped.data = static_cast<const unsigned char*>(view);
+	mapped.size = fileInfo.st_size;
+#endif
+	return true;
+}
+
+//Gets the png's size and last modified time, returns false if the png doesn't exist
+bool TextureCooker::sourceStamp(const char* pngPath, unsigned long long& size, unsigned long long& modifiedTime) {
+	struct stat info;
+	if (stat(pngPath, &info) != 0) {
+		return false;
+	}
+	size = (unsigned long long)info.st_size;
+	modifiedTime = (unsigned long long)info.st_mtime;
+	return true;
+}
+
+//Writes bitCount bits of value into a block, starting at bitPos (least significant bit first, which is the order BC7 expects)
+static void putBits(unsigned char* block, int& bitPos, unsigned int value, int bitCount) {
+	for (int i = 0; i < bitCount; i++) {
+		if ((value >> i) & 1) {
+			block[bitPos >> 3] |= (unsigned char)(1 << (bitPos & 7));
+		}
+		bitPos++;
+	}
+}
+
+//Converts a colour into the 16 bit 5:6:5 format used by BC1 endpoints
+static unsigned short packRGB565(const float colour[4]) {
+	int r = (int)std::lround(std::min(std::max(colour[0], 0.f), 255.f) * 31.f / 255.f);
+	int g = (int)std::lround(std::min(std::max(colour[1], 0.f), 255.f) * 63.f / 255.f);
+	int b = (int)std::lround(std::min(std::max(colour[2], 0.f), 255.f) * 31.f / 255.f);
+	return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+//Expands a 5:6:5 colour back to 8 bits per channel, the same way the GPU does when it decodes the block
+static void unpackRGB565(unsigned short colour, int out[3]) {
+	int r = (colour >> 11) & 31;
+	int g = (colour >> 5) & 63;
+	int b = colour & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+//Finds the two colours at either end of the line that best fits the pixels (the principal axis of the colours)
+//Every pixel in a block is then stored as a position along that line, so the better the line fits the better the quality
+void TextureCooker::findEndpoints(const unsigned char* rgba, int pixelCount, int channels, float endpointA[4], float endpointB[4]) {
+	float mean[4] = { 0.f, 0.f, 0.f, 0.f };
+	for (int i = 0; i < pixelCount; i++) {
+		for (int c = 0; c < channels; c++) { mean[c] += rgba[i * 4 + c]; }
+	}
+	for (int c = 0; c < channels; c++) { mean[c] /= pixelCount; }
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < pixelCount; i++) {
+		for (int r = 0; r < channels; r++) {
+			for (int c = 0; c < channels; c++) {
+				covariance[r][c] += (rgba[i * 4 + r] - mean[r]) * (rgba[i * 4 + c] - mean[c]);
+			}
+		}
+	}
+
+	//Power iteration, repeatedly multiplying a vector by the covariance matrix makes it point along the principal axis
+	float axis[4] = { 1.f, 1.f, 1.f, 1.f };
+	for (int iteration = 0; iteration < 8; iteration++) {
+		float next[4] = { 0.f, 0.f, 0.f, 0.f };
+		for (int r = 0; r < channels; r++) {
+			for (int c = 0; c < channels; c++) { next[r] += covariance[r][c] * axis[c]; }
+		}
+		float length = 0.f;
+		for (int c = 0; c < channels; c++) { length += next[c] * next[c]; }
+		length = std::sqrt(length);
+		//Every pixel is the same colour, any axis will do
+		if (length < 1e-6f) { break; }
+		for (int c = 0; c < channels; c++) { axis[c] = next[c] / length; }
+	}
+
+	float minT = 0.f, maxT = 0.f;
+	for (int i = 0; i < pixelCount; i++) {
+		float t = 0.f;
+		for (int c = 0; c < channels; c++) { t += (rgba[i * 4 + c] - mean[c]) * axis[c]; }
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	for (int c = 0; c < 4; c++) {
+		if (c < channels) {
+			endpointA[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.f), 255.f);
+			endpointB[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.f), 255.f);
+		}
+		else {
+			endpointA[c] = 255.f;
+			endpointB[c] = 255.f;
+		}
+	}
+}
+
+//BC1: two 5:6:5 endpoint colours and a 2 bit index per pixel choosing between the endpoints and 2 colours between them
+//If allowAlpha is true and some pixels are transparent, the 3 colour mode is used where index 3 means fully transparent
+void TextureCooker::compressBC1Block(const unsigned char* rgba, unsigned char* out, bool allowAlpha) {
+	unsigned char opaquePixels[64];
+	int opaqueCount = 0;
+	bool hasAlpha = false;
+	for (int i = 0; i < 16; i++) {
+		if (allowAlpha && rgba[i * 4 + 3] < 128) {
+			hasAlpha = true;
+			continue;
+		}
+		std::memcpy(&opaquePixels[opaqueCount * 4], &rgba[i * 4], 4);
+		opaqueCount++;
+	}
+
+	unsigned short colour0 = 0, colour1 = 0;
+	if (opaqueCount > 0) {
+		float endpointA[4], endpointB[4];
+		findEndpoints(opaquePixels, opaqueCount, 3, endpointA, endpointB);
+		colour0 = packRGB565(endpointB);
+		colour1 = packRGB565(endpointA);
+	}
+	//The order of the endpoints tells the GPU which mode the block uses: colour0 > colour1 is 4 colour mode, otherwise 3 colour + transparent
+	if ((hasAlpha && colour0 > colour1) || (!hasAlpha && colour0 < colour1)) {
+		std::swap(colour0, colour1);
+	}
+	int numColours = (hasAlpha || colour0 == colour1) ? 3 : 4;
+
+	int palette[4][3];
+	unpackRGB565(colour0, palette[0]);
+	unpackRGB565(colour1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		if (numColours == 4) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	unsigned int indices = 0;
+	for (int i = 0; i < 16; i++) {
+		int bestIndex = 0;
+		if (hasAlpha && rgba[i * 4 + 3] < 128) {
+			bestIndex = 3;
+		}
+		else {
+			int bestError = INT_MAX;
+			for (int p = 0; p < numColours; p++) {
+				int error = 0;
+				for (int c = 0; c < 3; c++) {
+					int difference = rgba[i * 4 + c] - palette[p][c];
+					error += difference * difference;
+				}
+				if (error < bestError) { bestError = error; bestIndex = p; }
+			}
+		}
+		indices |= (unsigned int)bestIndex << (i * 2);
+	}
+
+	out[0] = colour0 & 0xFF; out[1] = colour0 >> 8;
+	out[2] = colour1 & 0xFF; out[3] = colour1 >> 8;
+	out[4] = indices & 0xFF; out[5] = (indices >> 8) & 0xFF;
+	out[6] = (indices >> 16) & 0xFF; out[7] = (indices >> 24) & 0xFF;
+}
+
+//BC4: a single channel stored as two 8 bit endpoints and a 3 bit index per pixel, BC3 uses this for the alpha channel
+void TextureCooker::compressBC4Block(const unsigned char* rgba, int channel, unsigned char* out) {
+	int minValue = 255, maxValue = 0;
+	for (int i = 0; i < 16; i++) {
+		minValue = std::min(minValue, (int)rgba[i * 4 + channel]);
+		maxValue = std::max(maxValue, (int)rgba[i * 4 + channel]);
+	}
+	//maxValue > minValue selects the 8 value mode, if they are equal every index is 0 which decodes to maxValue
+	int palette[8];
+	palette[0] = maxValue;
+	palette[1] = minValue;
+	for (int i = 2; i < 8; i++) {
+		palette[i] = ((8 - i) * maxValue + (i - 1) * minValue) / 7;
+	}
+
+	unsigned long long indices = 0;
+	if (maxValue > minValue) {
+		for (int i = 0; i < 16; i++) {
+			int bestIndex = 0, bestError = INT_MAX;
+			for (int p = 0; p < 8; p++) {
+				int error = std::abs(rgba[i * 4 + channel] - palette[p]);
+				if (error < bestError) { bestError = error; bestIndex = p; }
+			}
+			indices |= (unsigned long long)bestIndex << (i * 3);
+		}
+	}
+
+	out[0] = (unsigned char)maxValue;
+	out[1] = (unsigned char)minValue;
+	for (int b = 0; b < 6; b++) {
+		out[2 + b] = (indices >> (b * 8)) & 0xFF;
+	}
+}
+
+//BC7 mode 6: one pair of RGBA endpoints (7 bits per channel plus a shared low bit per endpoint) and a 4 bit index per pixel
+//Only one of BC7's eight modes is used, it handles alpha well and is simple enough to encode quickly
+void TextureCooker::compressBC7Block(const unsigned char* rgba, unsigned char* out) {
+	float endpoints[2][4];
+	findEndpoints(rgba, 16, 4, endpoints[0], endpoints[1]);
+
+	//Quantise each endpoint to 7 bits per channel, trying both values of the endpoint's p-bit (the shared least significant bit)
+	int quantised[2][4];
+	int pBits[2];
+	int reconstructed[2][4];
+	for (int e = 0; e < 2; e++) {
+		float bestError = 1e30f;
+		for (int p = 0; p < 2; p++) {
+			float error = 0.f;
+			int candidate[4];
+			for (int c = 0; c < 4; c++) {
+				candidate[c] = std::min(std::max((int)std::lround((endpoints[e][c] - p) / 2.f), 0), 127);
+				float difference = ((candidate[c] << 1) | p) - endpoints[e][c];
+				error += difference * difference;
+			}
+			if (error < bestError) {
+				bestError = error;
+				pBits[e] = p;
+				for (int c = 0; c < 4; c++) { quantised[e][c] = candidate[c]; }
+			}
+		}
+		for (int c = 0; c < 4; c++) { reconstructed[e][c] = (quantised[e][c] << 1) | pBits[e]; }
+	}
+
+	int indices[16];
+	for (int i = 0; i < 16; i++) {
+		int bestIndex = 0, bestError = INT_MAX;
+		for (int w = 0; w < 16; w++) {
+			int error = 0;
+			for (int c = 0; c < 4; c++) {
+				int value = ((64 - bc7Weights[w]) * reconstructed[0][c] + bc7Weights[w] * reconstructed[1][c] + 32) >> 6;
+				int difference = rgba[i * 4 + c] - value;
+				error += difference * difference;
+			}
+			if (error < bestError) { bestError = error; bestIndex = w; }
+		}
+		indices[i] = bestIndex;
+	}
+
+	//The first index is stored with only 3 bits so its top bit must be 0, if it isn't swap the endpoints and flip every index
+	if (indices[0] & 8) {
+		for (int c = 0; c < 4; c++) { std::swap(quantised[0][c], quantised[1][c]); }
+		std::swap(pBits[0], pBits[1]);
+		for (int i = 0; i < 16; i++) { indices[i] = 15 - indices[i]; }
+	}
+
+	std::memset(out, 0, 16);
+	int bitPos = 0;
+	putBits(out, bitPos, 1 << 6, 7); //Mode 6 is written as six 0 bits followed by a 1
+	for (int c = 0; c < 4; c++) {
+		putBits(out, bitPos, quantised[0][c], 7);
+		putBits(out, bitPos, quantised[1][c], 7);
+	}
+	putBits(out, bitPos, pBits[0], 1);
+	putBits(out, bitPos, pBits[1], 1);
+	putBits(out, bitPos, indices[0], 3);
+	for (int i = 1; i < 16; i++) {
+		putBits(out, bitPos, indices[i], 4);
+	}
+}
+
+//Creates every mip level by averaging each 2x2 square of pixels of the previous level, until the level is 1x1
+void TextureCooker::buildMipChain(const unsigned char* pixels, int width, int height, std::vector<std::vector<unsigned char>>& levels, std::vector<CookedMipLevel>& levelInfo) {
+	levels.push_back(std::vector<unsigned char>(pixels, pixels + width * height * 4));
+	levelInfo.push_back({ 0, 0, (unsigned int)width, (unsigned int)height });
+
+	while (width > 1 || height > 1) {
+		int newWidth = std::max(1, width / 2);
+		int newHeight = std::max(1, height / 2);
+		const std::vector<unsigned char>& source = levels.back();
+		std::vector<unsigned char> level(newWidth * newHeight * 4);
+
+		for (int y = 0; y < newHeight; y++) {
+			for (int x = 0; x < newWidth; x++) {
+				//Clamp to the edge so odd sized (or 1 pixel wide) levels still work
+				int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+				int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+				for (int c = 0; c < 4; c++) {
+					int sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c]
+						+ source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+					level[(y * newWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		width = newWidth;
+		height = newHeight;
+		levels.push_back(level);
+		levelInfo.push_back({ 0, 0, (unsigned int)width, (unsigned int)height });
+	}
+}
+
+//Splits a mip level into 4x4 blocks and compresses each one, levels smaller than 4x4 repeat their edge pixels to fill the block
+void TextureCooker::compressLevel(const std::vector<unsigned char>& pixels, int width, int height, CookedFormat format, std::vector<unsigned char>& out) {
+	int blockBytes = format == CookedFormat::BC1 ? 8 : 16;
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	out.assign(blocksX * blocksY * blockBytes, 0);
+
+	unsigned char block[64];
+	for (int by = 0; by < blocksY; by++) {
+		for (int bx = 0; bx < blocksX; bx++) {
+			for (int py = 0; py < 4; py++) {
+				for (int px = 0; px < 4; px++) {
+					int x = std::min(bx * 4 + px, width - 1);
+					int y = std::min(by * 4 + py, height - 1);
+					std::memcpy(&block[(py * 4 + px) * 4], &pixels[(y * width + x) * 4], 4);
+				}
+			}
+			unsigned char* blockOut = &out[(by * blocksX + bx) * blockBytes];
+			switch (format) {
+			case CookedFormat::BC1:
+				compressBC1Block(block, blockOut, true);
+				break;
+			case CookedFormat::BC3:
+				//BC3 is a BC4 block for alpha followed by a BC1 block for colour (which is always in 4 colour mode)
+				compressBC4Block(block, 3, blockOut);
+				compressBC1Block(block, blockOut + 8, false);
+				break;
+			case CookedFormat::BC7:
+				compressBC7Block(block, blockOut);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+//Loads a png, builds its mip chain, compresses it (if requested) and writes it out as a .sjtex file
+bool TextureCooker::cookTexture(const char* pngPath, const char* outPath, CookedFormat format, bool flipVertically)
+{
+	stbi_set_flip_vertically_on_load(flipVertically);
+	int width, height, numChannels;
+	//Always decode to 4 channels so every level has the same layout no matter what the png contained
+	unsigned char* pixels = stbi_load(pngPath, &width, &height, &numChannels, 4);
+	if (!pixels) {
+		std::cout << "Failed to load texture for cooking: " << pngPath << std::endl;
+		return false;
+	}
+
+	std::vector<std::vector<unsigned char>> levels;
+	std::vector<CookedMipLevel> levelInfo;
+	buildMipChain(pixels, width, height, levels, levelInfo);
+	stbi_image_free(pixels);
+
+	if (format != CookedFormat::RGBA8) {
+		for (size_t i = 0; i < levels.size(); i++) {
+			std::vector<unsigned char> compressed;
+			compressLevel(levels[i], levelInfo[i].width, levelInfo[i].height, format, compressed);
+			levels[i].swap(compressed);
+		}
+	}
+
+	CookedTextureHeader header = {};
+	std::memcpy(header.magic, "SJTX", 4);
+	header.version = cookedTextureVersion;
+	header.format = (unsigned int)format;
+	header.width = width;
+	header.height = height;
+	header.mipCount = (unsigned int)levels.size();
+	header.flippedVertically = flipVertically ? 1 : 0;
+	sourceStamp(pngPath, header.sourceSize, header.sourceModifiedTime);
+
+	//Work out where each level will go, every level starts on a 16 byte boundary
+	unsigned int offset = sizeof(CookedTextureHeader) + sizeof(CookedMipLevel) * header.mipCount;
+	for (size_t i = 0; i < levels.size(); i++) {
+		offset = (offset + 15) & ~15u;
+		levelInfo[i].offset = offset;
+		levelInfo[i].size = (unsigned int)levels[i].size();
+		offset += levelInfo[i].size;
+	}
+
+	std::ofstream outFile(outPath, std::ios::binary | std::ios::trunc);
+	if (!outFile) {
+		std::cout << "Failed to write cooked texture: " << outPath << std::endl;
+		return false;
+	}
+	outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	outFile.write(reinterpret_cast<const char*>(levelInfo.data()), sizeof(CookedMipLevel) * levelInfo.size());
+	for (size_t i = 0; i < levels.size(); i++) {
+		while ((unsigned int)outFile.tellp() < levelInfo[i].offset) { outFile.put(0); }
+		outFile.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+	}
+	return true;
+}
+
+//Cooks every png inside a folder, the cooked files are written next to the pngs
+//Returns the number of textures that were cooked
+int TextureCooker::cookDirectory(const char* directory, CookedFormat format)
+{
+	std::vector<std::string> pngFiles;
+#ifdef _WIN32
+	const char* separator = "\\";
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA((std::string(directory) + "\\*.png").c_str(), &findData);
+	if (findHandle != INVALID_HANDLE_VALUE) {
+		do {
+			pngFiles.push_back(findData.cFileName);
+		} while (FindNextFileA(findHandle, &findData));
+		FindClose(findHandle);
+	}
+#else
+	const char* separator = "/";
+	DIR* dir = opendir(directory);
+	if (dir) {
+		while (dirent* entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0) {
+				pngFiles.push_back(name);
+			}
+		}
+		closedir(dir);
+	}
+#endif
+
+	int cooked = 0;
+	for (const std::string& name : pngFiles) {
+		std::string pngPath = std::string(directory) + separator + name;
+		std::string outPath = cookedPathFor(pngPath.c_str());
+		//Everything is cooked flipped because that is what the 3D objects use, GUI images flip their UVs instead
+		if (cookTexture(pngPath.c_str(), outPath.c_str(), format, true)) {
+			std::cout << "Cooked " << pngPath << " -> " << outPath << std::endl;
+			cooked++;
+		}
+	}
+	return cooked;
+}
+
+//Converts the name given on the command line into a format
+bool TextureCooker::parseFormat(const std::string& name, CookedFormat& format)
+{
+	if (name == "rgba") { format = CookedFormat::RGBA8; }
+	else if (name == "bc1") { format = CookedFormat::BC1; }
+	else if (name == "bc3") { format = CookedFormat::BC3; }
+	else if (name == "bc7") { format = CookedFormat::BC7; }
+	else { return false; }
+	return true;
+}
+
+std::string TextureCooker::cookedPathFor(const char* pngPath)
+{
+	std::string path = pngPath;
+	size_t extension = path.find_last_of('.');
+	if (extension != std::string::npos) {
+		path.erase(extension);
+	}
+	return path + ".sjtex";
+}
+
+//Maps the cooked file into memory and checks it can be used, this doesn't touch OpenGL so it is safe to call from a loading thread
+//Returns false if the file doesn't exist, is out of date, or the GPU doesn't support its format
+bool TextureCooker::openCookedTexture(const char* cookedPath, const char* pngPath, MappedFile& mapped)
+{
+	if (!mapFile(cookedPath, mapped)) {
+		return false;
+	}
+
+	const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(mapped.data);
+	if (mapped.size < sizeof(CookedTextureHeader) || std::memcmp(header->magic, "SJTX", 4) != 0 || header->version != cookedTextureVersion
+		|| mapped.size < sizeof(CookedTextureHeader) + sizeof(CookedMipLevel) * header->mipCount) {
+		std::cout << "Cooked texture is invalid or out of date: " << cookedPath << std::endl;
+		unmapFile(mapped);
+		return false;
+	}
+
+	//If the png has been edited since it was cooked, the png is used until it is cooked again
+	//A missing png is fine, a build can ship only the cooked files
+	unsigned long long sourceSize, sourceModifiedTime;
+	if (sourceStamp(pngPath, sourceSize, sourceModifiedTime) && (sourceSize != header->sourceSize || sourceModifiedTime != header->sourceModifiedTime)) {
+		std::cout << "Cooked texture is older than " << pngPath << ", loading the png instead (run with --cook to update it)" << std::endl;
+		unmapFile(mapped);
+		return false;
+	}
+
+	//Not every GPU can decode every format, if it can't the caller falls back to loading the png
+	bool supported;
+	switch ((CookedFormat)header->format) {
+	case CookedFormat::RGBA8: supported = true; break;
+	case CookedFormat::BC1:
+	case CookedFormat::BC3: supported = GLEW_EXT_texture_compression_s3tc; break;
+	case CookedFormat::BC7: supported = GLEW_ARB_texture_compression_bptc; break;
+	default: supported = false; break;
+	}
+	if (!supported) {
+		unmapFile(mapped);
+		return false;
+	}
+
+	const CookedMipLevel* levels = reinterpret_cast<const CookedMipLevel*>(header + 1);
+	for (unsigned int i = 0; i < header->mipCount; i++) {
+		if ((size_t)levels[i].offset + levels[i].size > mapped.size) {
+			std::cout << "Cooked texture is truncated: " << cookedPath << std::endl;
+			unmapFile(mapped);
+			return false;
+		}
+	}
+	return true;
+}
+
+//Uploads every mip level of an opened cooked texture straight from the mapping, then unmaps the file
+GLuint TextureCooker::uploadCookedTexture(MappedFile& mapped, int& outWidth, int& outHeight, bool& outFlippedVertically)
+{
+	const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(mapped.data);
+	const CookedMipLevel* levels = reinterpret_cast<const CookedMipLevel*>(header + 1);
+
+	GLenum internalFormat = GL_RGBA8;
+	switch ((CookedFormat)header->format) {
+	case CookedFormat::BC1: internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+	case CookedFormat::BC3: internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+	case CookedFormat::BC7: internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB; break;
+	default: break;
+	}
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	//Tells OpenGL how many levels we are giving it, so it doesn't expect any more
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->mipCount - 1);
+
+	for (unsigned int i = 0; i < header->mipCount; i++) {
+		const unsigned char* levelData = mapped.data + levels[i].offset;
+		if ((CookedFormat)header->format == CookedFormat::RGBA8) {
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, levels[i].width, levels[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levelData);
+		}
+		else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, levels[i].width, levels[i].height, 0, levels[i].size, levelData);
+		}
+	}
+
+	outWidth = header->width;
+	outHeight = header->height;
+	outFlippedVertically = header->flippedVertically != 0;
+	unmapFile(mapped);
+	return texture;
+}
+
+//Opens and uploads a cooked texture in one go, returns 0 if it couldn't be loaded
+GLuint TextureCooker::loadCookedTexture(const char* cookedPath, const char* pngPath, int& outWidth, int& outHeight, bool& outFlippedVertically)
+{
+	MappedFile mapped;
+	if (!openCookedTexture(cookedPath, pngPath, mapped)) {
+		return 0;
+	}
+	return uploadCookedTexture(mapped, outWidth, outHeight, outFlippedVertically);
+}
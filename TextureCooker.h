@@ -0,0 +1,73 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+//The different formats a texture can be cooked into
+//RGBA8 is uncompressed, the BC formats are block compressed (every 4x4 block of pixels is stored in 8 or 16 bytes)
+enum class CookedFormat : unsigned int {
+	RGBA8 = 0,
+	BC1 = 1, //8 bytes per block, RGB with 1 bit of alpha
+	BC3 = 2, //16 bytes per block, RGB with a full alpha channel
+	BC7 = 3  //16 bytes per block, highest quality RGBA
+};
+
+//Every cooked texture file (.sjtex) begins with this header
+//It is followed by one CookedMipLevel entry per mip level, and then the image data of every level
+struct CookedTextureHeader {
+	char magic[4]; //Always "SJTX", used to check the file really is a cooked texture
+	unsigned int version;
+	unsigned int format; //A CookedFormat value
+	unsigned int width, height;
+	unsigned int mipCount;
+	unsigned int flippedVertically; //1 if the rows were flipped on load (the same as stbi_set_flip_vertically_on_load(true))
+	unsigned int reserved;
+	//The size and last modified time of the png when it was cooked, if the png has changed since then the cooked file is stale
+	unsigned long long sourceSize, sourceModifiedTime;
+};
+
+//Describes where a single mip level is stored inside the cooked file
+struct CookedMipLevel {
+	unsigned int offset; //Byte offset from the start of the file
+	unsigned int size; //Size of the level in bytes
+	unsigned int width, height;
+};
+
+//A file that has been mapped into memory, the contents can be read through data without copying the file first
+//file and mapping are the operating system handles (only used on Windows)
+struct MappedFile {
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	void* file = nullptr;
+	void* mapping = nullptr;
+};
+
+//The TextureCooker converts PNG files into .sjtex files offline (run the game with --cook)
+//The cooked file stores a complete mip chain so the game doesn't need to decode PNGs or generate mipmaps when it starts
+//At runtime the cooked file is memory mapped and each level is handed straight to OpenGL
+class TextureCooker
+{
+public:
+	static bool cookTexture(const char* pngPath, const char* outPath, CookedFormat format, bool flipVertically);
+	static int cookDirectory(const char* directory, CookedFormat format);
+	static bool parseFormat(const std::string& name, CookedFormat& format);
+
+	//Returns the path of the cooked version of a png, Textures\\moon.png -> Textures\\moon.sjtex
+	static std::string cookedPathFor(const char* pngPath);
+	//Loads a cooked texture into OpenGL, returns 0 if the file doesn't exist, the png has changed since it was cooked, or the GPU doesn't support its format
+	static GLuint loadCookedTexture(const char* cookedPath, const char* pngPath, int& outWidth, int& outHeight, bool& outFlippedVertically);
+	//The same as loadCookedTexture split in two, so the file can be opened on a loading thread and uploaded later
+	static bool openCookedTexture(const char* cookedPath, const char* pngPath, MappedFile& mapped);
+	static GLuint uploadCookedTexture(MappedFile& mapped, int& outWidth, int& outHeight, bool& outFlippedVertically);
+	static void unmapFile(MappedFile& mapped);
+
+	static void compressBC1Block(const unsigned char* rgba, unsigned char* out, bool allowAlpha);
+	static void compressBC4Block(const unsigned char* rgba, int channel, unsigned char* out);
+	static void compressBC7Block(const unsigned char* rgba, unsigned char* out);
+private:
+	static bool mapFile(const char* path, MappedFile& mapped);
+	static bool sourceStamp(const char* pngPath, unsigned long long& size, unsigned long long& modifiedTime);
+	static void buildMipChain(const unsigned char* pixels, int width, int height, std::vector<std::vector<unsigned char>>& levels, std::vector<CookedMipLevel>& levelInfo);
+	static void compressLevel(const std::vector<unsigned char>& pixels, int width, int height, CookedFormat format, std::vector<unsigned char>& out);
+	static void findEndpoints(const unsigned char* rgba, int pixelCount, int channels, float endpointA[4], float endpointB[4]);
+};
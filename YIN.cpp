@@ -1,10 +1,15 @@
 #include "YIN.h"
+#include "JobSystem.h"
+#include "CPUProfiler.h"
 
 //Constants needed for calculating the fourier transforms
 const double pi = acos(0.0f) * 2;
 const std::complex<double> negi = std::complex<double>(0.f, -2.f * pi); //Used for calculating forward fourier transform
 const std::complex<double> posi = std::complex<double>(0.f, 2.f * pi); //Used for calculating the inverse fourier transform
 
+//Transforms at least this big have their two halves worked out by separate jobs, smaller ones aren't worth splitting
+const int parallelTransformSize = 1024;
+
 //The maximum frequency I want to calculate for and the lowest (determines the tau values I calculate for)
 int frequencyMax = 1000.f;
 int frequencyMin = 70.f;
@@ -46,8 +51,17 @@ std::valarray<std::complex<double>> YIN::fourierTransform(std::valarray<std::com
 	Pe = P[std::slice(0, n / 2, 2)];
 	Po = P[std::slice(1, n / 2, 2)];
 	//Recursive call of the main function
-	Pe = fourierTransform(Pe);
-	Po = fourierTransform(Po);
+	//The two halves don't depend on each other, so a big transform does the even half in a job while this thread does the odd half
+	if (n >= parallelTransformSize) {
+		JobCounter evenDone;
+		JobSystem::run([&Pe]() { Pe = fourierTransform(Pe); }, evenDone);
+		Po = fourierTransform(Po);
+		JobSystem::wait(evenDone);
+	}
+	else {
+		Pe = fourierTransform(Pe);
+		Po = fourierTransform(Po);
+	}
 
 	Y.resize(n);
 
@@ -82,8 +96,16 @@ std::valarray<std::complex<double>> YIN::inverseFourierTransform(std::valarray<s
 	Pe = P[std::slice(0, n / 2, 2)];
 	Po = P[std::slice(1, n / 2, 2)];
 
-	Pe = inverseFourierTransform(Pe);
-	Po = inverseFourierTransform(Po);
+	if (n >= parallelTransformSize) {
+		JobCounter evenDone;
+		JobSystem::run([&Pe]() { Pe = inverseFourierTransform(Pe); }, evenDone);
+		Po = inverseFourierTransform(Po);
+		JobSystem::wait(evenDone);
+	}
+	else {
+		Pe = inverseFourierTransform(Pe);
+		Po = inverseFourierTransform(Po);
+	}
 
 	//Y.reserve(n);
 	Y.resize(n);
@@ -167,6 +189,7 @@ int YIN::calculatePitch(std::valarray<std::complex<double>> cmndf, int tauMin, i
 
 float YIN::YINalgorithm(std::valarray<std::complex<double>> signal)
 {
+	PROFILE_ZONE("YIN::YINalgorithm");
 	//Might be reverse of what you expect, tau means latency (or the period of the wave) so the minimum latency to calculate for would be the period of the maximum frequency and vice versa
 	//44100 is the (expected) sampling rate
 	int tauMin = floor(44100 / frequencyMax);